@@ -1,8 +1,30 @@
 #include "rs-options/options.hpp"
 #include "rs-format/terminal.hpp"
-#include <set>
+#include <cerrno>
+#include <climits>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <system_error>
+#include <thread>
+
+#ifdef _WIN32
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define RS_OPTIONS_SSE2 1
+    #include <emmintrin.h>
+#endif
 
 using namespace RS::Format;
+using namespace RS::RE;
 using namespace RS::Format::Literals;
 using namespace std::literals;
 
@@ -14,6 +36,466 @@ namespace RS::Option {
             return trim(name, std::string(ascii_whitespace) + '-');
         }
 
+        std::string_view trim_name_view(std::string_view name) noexcept {
+            static constexpr std::string_view trim_chars = " \t\n\v\f\r-";
+            auto i = name.find_first_not_of(trim_chars);
+            if (i == npos)
+                return {};
+            auto j = name.find_last_not_of(trim_chars);
+            return name.substr(i, j - i + 1);
+        }
+
+        // Worker threads shared by every parallel batch in one parse, so
+        // that threads are started once per parse rather than once per
+        // option, and never more than the hardware supports
+
+        class worker_pool {
+
+        public:
+
+            worker_pool() = default;
+            ~worker_pool() noexcept;
+            worker_pool(const worker_pool&) = delete;
+            worker_pool& operator=(const worker_pool&) = delete;
+
+            static size_t capacity() noexcept { return std::max(std::thread::hardware_concurrency(), 1u); }
+            void run(size_t tasks, const std::function<void(size_t)>& task);
+
+        private:
+
+            std::vector<std::thread> threads_;  // Started on first use
+            std::mutex mutex_;
+            std::condition_variable wake_;
+            std::condition_variable done_;
+            const std::function<void(size_t)>* task_ = nullptr;
+            size_t next_ = 0;
+            size_t total_ = 0;
+            size_t finished_ = 0;
+            bool stop_ = false;
+
+            void work();
+
+        };
+
+        worker_pool::~worker_pool() noexcept {
+            {
+                std::unique_lock lock(mutex_);
+                stop_ = true;
+            }
+            wake_.notify_all();
+            for (auto& thread: threads_)
+                thread.join();
+        }
+
+        // The calling thread takes tasks too; tasks must not throw
+
+        void worker_pool::run(size_t tasks, const std::function<void(size_t)>& task) {
+
+            if (threads_.empty())
+                for (size_t i = 1; i < capacity(); ++i)
+                    threads_.emplace_back([this] { work(); });
+
+            std::unique_lock lock(mutex_);
+            task_ = &task;
+            next_ = 0;
+            total_ = tasks;
+            finished_ = 0;
+            wake_.notify_all();
+
+            while (next_ < total_) {
+                size_t i = next_++;
+                lock.unlock();
+                task(i);
+                lock.lock();
+                ++finished_;
+            }
+
+            done_.wait(lock, [this] { return finished_ == total_; });
+            task_ = nullptr;
+
+        }
+
+        void worker_pool::work() {
+            std::unique_lock lock(mutex_);
+            for (;;) {
+                wake_.wait(lock, [this] { return stop_ || next_ < total_; });
+                if (stop_)
+                    return;
+                while (next_ < total_) {
+                    size_t i = next_++;
+                    auto task = task_;
+                    lock.unlock();
+                    (*task)(i);
+                    lock.lock();
+                    if (++finished_ == total_)
+                        done_.notify_all();
+                }
+            }
+        }
+
+        // The pool for the parse in progress on this thread, if any
+
+        thread_local worker_pool* current_pool = nullptr;
+
+        class pool_scope {
+        public:
+            pool_scope() noexcept: saved_(current_pool) { if (! current_pool) current_pool = &pool_; }
+            ~pool_scope() noexcept { current_pool = saved_; }
+            pool_scope(const pool_scope&) = delete;
+            pool_scope& operator=(const pool_scope&) = delete;
+        private:
+            worker_pool pool_;
+            worker_pool* saved_;
+        };
+
+        // Returns the number of bytes read, zero at end of file
+
+        size_t read_some(int fd, char* buffer, size_t size) {
+            for (;;) {
+                #ifdef _WIN32
+                    auto rc = _read(fd, buffer, unsigned(std::min(size, size_t(INT_MAX))));
+                #else
+                    auto rc = ::read(fd, buffer, size);
+                #endif
+                if (rc >= 0)
+                    return size_t(rc);
+                if (errno != EINTR)
+                    throw std::system_error(errno, std::generic_category(), "Error reading arguments");
+            }
+        }
+
+        // Fish doesn't recognise the '\'' idiom
+
+        std::string fish_quote(const std::string& str) {
+            std::string result = "'";
+            for (char c: str) {
+                if (c == '\'' || c == '\\')
+                    result += '\\';
+                result += c;
+            }
+            result += '\'';
+            return result;
+        }
+
+        std::string shell_quote(const std::string& str) {
+            std::string result = "'";
+            for (char c: str) {
+                if (c == '\'')
+                    result += "'\\''";
+                else
+                    result += c;
+            }
+            result += '\'';
+            return result;
+        }
+
+        std::string shell_name(const std::string& command) {
+            std::string result;
+            for (char c: command)
+                result += ascii_isalnum(c) ? c : '_';
+            return result;
+        }
+
+        std::string zsh_escape(const std::string& str) {
+            std::string result;
+            for (char c: str) {
+                if (c == '[' || c == ']' || c == ':' || c == '\\')
+                    result += '\\';
+                result += c;
+            }
+            return result;
+        }
+
+        // Bounded Levenshtein distance using the bit-parallel algorithm of
+        // Myers (1999), in the form given by Hyyro (2001). The pattern's
+        // match vectors are built once, then compared against each
+        // candidate. Patterns longer than 64 bytes fall back on the
+        // ordinary dynamic programming algorithm.
+
+        class EditDistance {
+
+        public:
+
+            explicit EditDistance(const std::string& pattern):
+            pattern_(pattern), peq_() {
+                if (pattern_.size() <= 64)
+                    for (size_t i = 0; i < pattern_.size(); ++i)
+                        peq_[uint8_t(pattern_[i])] |= uint64_t(1) << i;
+            }
+
+            // Returns a value greater than max if the distance exceeds max
+
+            size_t operator()(const std::string& text, size_t max) const {
+                size_t m = pattern_.size();
+                size_t n = text.size();
+                if ((m > n ? m - n : n - m) > max)
+                    return max + 1;
+                if (m == 0)
+                    return n;
+                if (m > 64)
+                    return slow_distance(text, max);
+                uint64_t last = uint64_t(1) << (m - 1);
+                uint64_t pv = ~ uint64_t(0);
+                uint64_t mv = 0;
+                size_t score = m;
+                for (size_t j = 0; j < n; ++j) {
+                    uint64_t eq = peq_[uint8_t(text[j])];
+                    uint64_t xv = eq | mv;
+                    uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+                    uint64_t ph = mv | ~ (xh | pv);
+                    uint64_t mh = pv & xh;
+                    if (ph & last)
+                        ++score;
+                    else if (mh & last)
+                        --score;
+                    // The score can fall by at most one per remaining character
+                    if (score > max + (n - j - 1))
+                        return max + 1;
+                    ph = (ph << 1) | 1;
+                    mh <<= 1;
+                    pv = mh | ~ (xv | ph);
+                    mv = ph & xv;
+                }
+                return score;
+            }
+
+        private:
+
+            std::string pattern_;
+            uint64_t peq_[256];
+
+            size_t slow_distance(const std::string& text, size_t max) const {
+                std::vector<size_t> prev(text.size() + 1), next(text.size() + 1);
+                for (size_t j = 0; j <= text.size(); ++j)
+                    prev[j] = j;
+                for (size_t i = 1; i <= pattern_.size(); ++i) {
+                    next[0] = i;
+                    size_t row_min = i;
+                    for (size_t j = 1; j <= text.size(); ++j) {
+                        size_t cost = pattern_[i - 1] == text[j - 1] ? 0 : 1;
+                        next[j] = std::min({prev[j] + 1, next[j - 1] + 1, prev[j - 1] + cost});
+                        row_min = std::min(row_min, next[j]);
+                    }
+                    if (row_min > max)
+                        return max + 1;
+                    prev.swap(next);
+                }
+                return prev.back();
+            }
+
+        };
+
+        // Returns the closest candidate, or an empty string if nothing is
+        // close enough to be a plausible typo
+
+        template <typename Range, typename Key>
+        std::string closest_match(const std::string& str, const Range& range, Key key) {
+            EditDistance distance(str);
+            size_t max = std::clamp(str.size() / 2, size_t(1), size_t(3));
+            std::string best;
+            for (auto& item: range) {
+                const std::string& candidate = key(item);
+                size_t d = distance(candidate, max);
+                if (d <= max) {
+                    best = candidate;
+                    if (d == 0)
+                        break;
+                    max = d - 1;
+                }
+            }
+            return best;
+        }
+
+        // 32-bit FNV-1a, used to skip most name comparisons in lookups
+
+        uint32_t name_hash(std::string_view str) noexcept {
+            uint32_t h = 2'166'136'261u;
+            for (char c: str) {
+                h ^= uint8_t(c);
+                h *= 16'777'619u;
+            }
+            return h;
+        }
+
+        // Returns the offset of the first malformed sequence, or npos if the
+        // string is valid UTF-8 (overlong forms, surrogates, and code points
+        // past U+10FFFF are malformed). Runs of ASCII, which is almost all
+        // of any real command line, are skipped 16 or 8 bytes at a time.
+
+        size_t utf8_error(std::string_view str) noexcept {
+
+            auto ptr = reinterpret_cast<const uint8_t*>(str.data());
+            size_t n = str.size();
+            size_t i = 0;
+
+            while (i < n) {
+
+                #ifdef RS_OPTIONS_SSE2
+                    // Bit k of the mask is set if byte k of the block is not ASCII
+                    auto high_bits = [ptr] (size_t pos) {
+                        return unsigned(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + pos))));
+                    };
+                    while (n - i >= 16 && high_bits(i) == 0)
+                        i += 16;
+                    // A short tail is checked with one block ending at the end
+                    // of the string, ignoring the bytes already checked
+                    if (n - i < 16 && n >= 16 && (high_bits(n - 16) >> (16 - (n - i))) == 0)
+                        break;
+                #endif
+
+                for (uint64_t word = 0; n - i >= 8; i += 8) {
+                    std::memcpy(&word, ptr + i, 8);
+                    if ((word & 0x8080'8080'8080'8080ull) != 0)
+                        break;
+                }
+
+                while (i < n && ptr[i] < 0x80)
+                    ++i;
+                if (i == n)
+                    break;
+
+                uint8_t c = ptr[i];
+
+                // The second byte has a narrower range after some lead bytes
+
+                size_t len = 0;
+                uint8_t min = 0x80;
+                uint8_t max = 0xbf;
+
+                if (c >= 0xc2 && c <= 0xdf) {
+                    len = 2;
+                } else if (c >= 0xe0 && c <= 0xef) {
+                    len = 3;
+                    if (c == 0xe0)
+                        min = 0xa0;
+                    else if (c == 0xed)
+                        max = 0x9f;
+                } else if (c >= 0xf0 && c <= 0xf4) {
+                    len = 4;
+                    if (c == 0xf0)
+                        min = 0x90;
+                    else if (c == 0xf4)
+                        max = 0x8f;
+                } else {
+                    return i;
+                }
+
+                if (n - i < len || ptr[i + 1] < min || ptr[i + 1] > max)
+                    return i;
+                for (size_t j = 2; j < len; ++j)
+                    if ((ptr[i + j] & 0xc0) != 0x80)
+                        return i;
+
+                i += len;
+
+            }
+
+            return npos;
+
+        }
+
+        // Option specs are a flat sequence of little-endian integers and
+        // length-prefixed strings, so they can be read from any address
+
+        // Frozen results are native-endian, since they are only meant to be
+        // shared between processes on the same machine: a header of 64-bit
+        // words (magic number, options, arguments, name bytes, argument
+        // bytes), then the offset tables, then the text
+
+        constexpr uint64_t frozen_magic = 0x5a52465450534f52;  // "RSOPTFRZ"
+        constexpr size_t frozen_header = 5;
+
+        constexpr std::string_view spec_magic = "RSOPTSPC";
+        constexpr uint32_t spec_version = 2;  // Version 1 had no UTF-8 setting
+
+        class SpecWriter {
+        public:
+            void u8(uint8_t x) { data_ += char(x); }
+            void u32(uint32_t x) { for (int i = 0; i < 32; i += 8) data_ += char((x >> i) & 0xff); }
+            void str(const std::string& s) { u32(uint32_t(s.size())); data_ += s; }
+            std::string& data() noexcept { return data_; }
+        private:
+            std::string data_;
+        };
+
+        class SpecReader {
+        public:
+            explicit SpecReader(std::string_view data) noexcept: data_(data) {}
+            bool done() const noexcept { return pos_ == data_.size(); }
+            uint8_t u8() { need(1); return uint8_t(data_[pos_++]); }
+            uint32_t u32() {
+                need(4);
+                uint32_t x = 0;
+                for (int i = 0; i < 32; i += 8)
+                    x |= uint32_t(uint8_t(data_[pos_++])) << i;
+                return x;
+            }
+            std::string str() {
+                size_t n = u32();
+                need(n);
+                pos_ += n;
+                return std::string(data_.substr(pos_ - n, n));
+            }
+        private:
+            std::string_view data_;
+            size_t pos_ = 0;
+            void need(size_t n) const {
+                if (data_.size() - pos_ < n)
+                    throw Options::setup_error("Option spec is truncated");
+            }
+        };
+
+    }
+
+    InternedStrings::InternedStrings(const InternedStrings& s):
+    symbols_(s.symbols_), ids_(s.ids_) {
+        reindex();
+    }
+
+    InternedStrings& InternedStrings::operator=(const InternedStrings& s) {
+        if (&s != this) {
+            symbols_ = s.symbols_;
+            ids_ = s.ids_;
+            reindex();
+        }
+        return *this;
+    }
+
+    void InternedStrings::clear() noexcept {
+        symbols_.clear();
+        index_.clear();
+        ids_.clear();
+    }
+
+    std::optional<InternedStrings::id_type> InternedStrings::find(const std::string& str) const {
+        auto it = index_.find(str);
+        if (it == index_.end())
+            return {};
+        return it->second;
+    }
+
+    InternedStrings::iterator InternedStrings::insert(const_iterator pos, const std::string& str) {
+        auto id = intern(str);
+        ids_.insert(ids_.begin() + pos.index_, id);
+        return {this, pos.index_};
+    }
+
+    InternedStrings::id_type InternedStrings::intern(const std::string& str) {
+        auto it = index_.find(str);
+        if (it != index_.end())
+            return it->second;
+        if (symbols_.size() > std::numeric_limits<id_type>::max())
+            throw std::length_error("Too many distinct strings");
+        auto id = static_cast<id_type>(symbols_.size());
+        symbols_.push_back(str);
+        index_.insert({symbols_.back(), id});
+        return id;
+    }
+
+    void InternedStrings::reindex() {
+        index_.clear();
+        for (size_t i = 0; i < symbols_.size(); ++i)
+            index_.insert({symbols_[i], static_cast<id_type>(i)});
     }
 
     Options::setup_error::setup_error(const std::string& message):
@@ -22,15 +504,197 @@ namespace RS::Option {
     Options::user_error::user_error(const std::string& message):
     std::runtime_error(message) {}
 
+    size_t Options::parse_result::index(const std::string& name) const {
+        auto key = trim_name(name);
+        auto it = std::lower_bound(sorted_.begin(), sorted_.end(), key,
+            [this] (uint32_t i, const std::string& k) { return this->name(i) < k; });
+        if (it == sorted_.end() || this->name(*it) != key)
+            return npos;
+        return *it;
+    }
+
+    std::string_view Options::parse_result::name(size_t i) const noexcept {
+        return std::string_view(names_).substr(name_offsets_[i], name_offsets_[i + 1] - name_offsets_[i]);
+    }
+
+    bool Options::parse_result::found(const std::string& name) const {
+        auto i = index(name);
+        return i != npos && found(i);
+    }
+
+    size_t Options::parse_result::count(const std::string& name) const {
+        auto i = index(name);
+        return i == npos ? 0 : count(i);
+    }
+
+    size_t Options::parse_result::values(const std::string& name) const {
+        auto i = index(name);
+        return i == npos ? 0 : values(i);
+    }
+
+    size_t Options::parse_result::dropped(const std::string& name) const {
+        auto i = index(name);
+        return i == npos ? 0 : dropped(i);
+    }
+
+    std::string_view Options::parse_result::value(size_t i, size_t j) const noexcept {
+        size_t k = first_token_[i] + j;
+        return std::string_view(tokens_).substr(token_offsets_[k], token_offsets_[k + 1] - token_offsets_[k]);
+    }
+
+    std::string_view Options::parse_result::value(const std::string& name, size_t j) const {
+        auto i = index(name);
+        if (i == npos || j >= values(i))
+            return {};
+        return value(i, j);
+    }
+
+    size_t Options::parse_result::frozen_size() const noexcept {
+        size_t n = size();
+        size_t t = token_offsets_.empty() ? 0 : token_offsets_.size() - 1;
+        return 8 * (frozen_header + 4 * n + t + 3) + names_.size() + tokens_.size();
+    }
+
+    void Options::parse_result::freeze(void* dest) const noexcept {
+
+        size_t n = size();
+        size_t t = token_offsets_.empty() ? 0 : token_offsets_.size() - 1;
+        auto words = static_cast<uint64_t*>(dest);
+
+        // The offset tables of a default constructed result are empty
+
+        auto put = [&words] (const auto& table, size_t count) {
+            for (size_t i = 0; i < count; ++i)
+                *words++ = i < table.size() ? uint64_t(table[i]) : 0;
+        };
+
+        *words++ = frozen_magic;
+        *words++ = n;
+        *words++ = t;
+        *words++ = names_.size();
+        *words++ = tokens_.size();
+        put(name_offsets_, n + 1);
+        put(sorted_, n);
+        put(counts_, n);
+        put(first_token_, n + 1);
+        put(token_offsets_, t + 1);
+
+        auto chars = reinterpret_cast<char*>(words);
+        std::memcpy(chars, names_.data(), names_.size());
+        std::memcpy(chars + names_.size(), tokens_.data(), tokens_.size());
+
+    }
+
+    Options::frozen_result::frozen_result(const void* data, size_t bytes) {
+
+        // Everything is checked up front, so the accessors can't be led
+        // outside the block
+
+        auto words = static_cast<const uint64_t*>(data);
+
+        if (data == nullptr || reinterpret_cast<uintptr_t>(data) % alignof(uint64_t) != 0
+                || bytes < 8 * frozen_header || words[0] != frozen_magic)
+            throw setup_error("Not a frozen parse result");
+
+        uint64_t n = words[1];
+        uint64_t t = words[2];
+        uint64_t name_bytes = words[3];
+        uint64_t token_bytes = words[4];
+        uint64_t max_words = bytes / 8;
+
+        uint64_t table_words = frozen_header + 4 * n + t + 3;
+
+        if (n > max_words / 4 || t > max_words || table_words > max_words
+                || name_bytes > bytes || token_bytes > bytes || name_bytes + token_bytes > bytes - 8 * table_words)
+            throw setup_error("Frozen parse result is corrupt");
+
+        size_ = size_t(n);
+        name_offsets_ = words + frozen_header;
+        sorted_ = name_offsets_ + n + 1;
+        counts_ = sorted_ + n;
+        first_token_ = counts_ + n;
+        token_offsets_ = first_token_ + n + 1;
+        names_ = reinterpret_cast<const char*>(token_offsets_ + t + 1);
+        tokens_ = names_ + name_bytes;
+
+        auto ascending = [] (const uint64_t* table, size_t count, uint64_t last) {
+            if (table[0] != 0 || table[count - 1] != last)
+                return false;
+            for (size_t i = 1; i < count; ++i)
+                if (table[i] < table[i - 1])
+                    return false;
+            return true;
+        };
+
+        bool ok = ascending(name_offsets_, size_ + 1, name_bytes)
+            && ascending(first_token_, size_ + 1, t)
+            && ascending(token_offsets_, size_t(t) + 1, token_bytes)
+            && std::all_of(sorted_, sorted_ + n, [n] (uint64_t i) { return i < n; });
+
+        if (! ok)
+            throw setup_error("Frozen parse result is corrupt");
+
+    }
+
+    size_t Options::frozen_result::index(const std::string& name) const {
+        auto key = trim_name(name);
+        auto it = std::lower_bound(sorted_, sorted_ + size_, key,
+            [this] (uint64_t i, const std::string& k) { return this->name(size_t(i)) < k; });
+        if (it == sorted_ + size_ || this->name(size_t(*it)) != key)
+            return npos;
+        return size_t(*it);
+    }
+
+    std::string_view Options::frozen_result::name(size_t i) const noexcept {
+        return std::string_view(names_ + name_offsets_[i], size_t(name_offsets_[i + 1] - name_offsets_[i]));
+    }
+
+    bool Options::frozen_result::found(const std::string& name) const {
+        auto i = index(name);
+        return i != npos && found(i);
+    }
+
+    size_t Options::frozen_result::count(const std::string& name) const {
+        auto i = index(name);
+        return i == npos ? 0 : count(i);
+    }
+
+    size_t Options::frozen_result::values(const std::string& name) const {
+        auto i = index(name);
+        return i == npos ? 0 : values(i);
+    }
+
+    std::string_view Options::frozen_result::value(size_t i, size_t j) const noexcept {
+        size_t k = size_t(first_token_[i]) + j;
+        return std::string_view(tokens_ + token_offsets_[k], size_t(token_offsets_[k + 1] - token_offsets_[k]));
+    }
+
+    std::string_view Options::frozen_result::value(const std::string& name, size_t j) const {
+        auto i = index(name);
+        if (i == npos || j >= values(i))
+            return {};
+        return value(i, j);
+    }
+
     Options::Options(const std::string& app, const std::string& version,
         const std::string& description, const std::string& extra):
     options_(),
+    texts_(),
+    calls_(),
+    groups_(),
+    arena_(),
+    placeholders_(),
+    index_(),
+    result_(),
+    result_args_(),
+    stream_(),
     app_(trim(app)),
     version_(trim(version)),
     description_(trim(description)),
     extra_(trim(extra)),
     colour_(-1),
     allow_help_(false),
+    allow_prefix_(false),
     auto_help_(false) {
         if (app.empty())
             throw setup_error("No application name was supplied");
@@ -40,235 +704,1441 @@ namespace RS::Option {
             version_.insert(0, 1, ' ');
     }
 
-    bool Options::parse(std::vector<std::string> args, std::ostream& out) {
+    void Options::stream_args(const std::string& name, int fd, char delimiter, value_callback callback) {
+        auto index = option_index(name);
+        if (index == npos)
+            throw setup_error("Unknown option: --" + trim_name(name));
+        if (options_[index].kind == mode::boolean)
+            throw setup_error("Boolean options can't take streamed arguments: --" + name_of(index));
+        if (options_[index].kind != mode::multiple && ! callback)
+            throw setup_error("Streamed arguments need a multi-valued option or a callback: --" + name_of(index));
+        stream_ = {index, fd, delimiter, std::move(callback)};
+    }
+
+    bool Options::parse(std::vector<std::string> args, std::ostream& out) {
+        auto status = try_parse(std::move(args), out);
+        if (! status)
+            throw user_error(error_message(status.error()));
+        return *status;
+    }
+
+    bool Options::parse(int argc, char** argv, std::ostream& out) {
+        auto status = try_parse(argc, argv, out);
+        if (! status)
+            throw user_error(error_message(status.error()));
+        return *status;
+    }
+
+    Options::parse_status Options::try_parse(std::vector<std::string> args, std::ostream& out) {
+
+        if (args.size() == 1 && fast_exit(args[0], out))
+            return false;
+
+        // No views of the caller's arguments, so values for string_view
+        // targets are copied into the options' own storage
+        return do_parse(std::move(args), {}, out);
+
+    }
+
+    Options::parse_status Options::try_parse(int argc, char** argv, std::ostream& out) {
+        if (argc == 2 && fast_exit(argv[1], out))
+            return false;
+        std::vector<std::string> args(argv + 1, argv + argc);
+        std::vector<std::string_view> views(argv + 1, argv + argc);
+        return do_parse(std::move(args), views, out);
+    }
+
+    std::vector<Options::parse_error> Options::check(std::vector<std::string> args) {
+        add_standard();
+        std::vector<parse_error> errors;
+        if (! (args.empty() && auto_help_) && ! (! args.empty() && args[0] == complete_option))
+            parse_args(args, {}, true, errors);
+        return errors;
+    }
+
+    Options::parse_status Options::do_parse(std::vector<std::string> args,
+            const std::vector<std::string_view>& views, std::ostream& out) {
+
+        add_standard();
+
+        // Shell completion requests are answered from the name index alone,
+        // without running any validators or setters
+
+        if (! args.empty() && args[0] == complete_option) {
+            auto text = complete({args.begin() + 1, args.end()});
+            out.write(text.data(), std::streamsize(text.size()));
+            return false;
+        }
+
+        if (auto_help_ && args.empty()) {
+            out << format_help();
+            return false;
+        }
+
+        std::vector<parse_error> errors;
+        auto found = parse_args(args, views, false, errors);
+
+        for (size_t i = 0; i < options_.size(); ++i)
+            options_[i].found = found[i] != 0;
+
+        if (errors.empty() && stream_.option != npos && ! options_[option_index("help")].found
+                && ! options_[option_index("version")].found)
+            read_stream(args.size(), errors);
+
+        // The result is built from the arguments when it is first asked for
+
+        result_ = {};
+        result_pending_ = errors.empty();
+        result_args_ = errors.empty() ? std::move(args) : std::vector<std::string>();
+
+        if (! errors.empty())
+            return errors.front();
+
+        if (options_[option_index("help")].found) {
+            out << format_help();
+            return false;
+        }
+
+        if (options_[option_index("version")].found) {
+            out << app_ << version_ << "\n";
+            return false;
+        }
+
+        return true;
+
+    }
+
+
+    std::vector<Options::parse_error> Options::check(int argc, char** argv) {
+        std::vector<std::string> args(argv + 1, argv + argc);
+        return check(args);
+    }
+
+    std::vector<size_t> Options::reparse(std::vector<std::string> args) {
+
+        // The new arguments are scanned without conversion and compared with
+        // the last successful parse, and only options whose arguments differ
+        // are checked and set. Every changed option is checked before any
+        // variable is touched, so a failed reparse changes nothing.
+
+        add_standard();
+
+        std::vector<parse_error> errors;
+        token_scan scan;
+        parse_args(args, {}, true, errors, &scan);
+
+        if (! errors.empty())
+            throw user_error(error_message(errors.front()));
+
+        size_t n = options_.size();
+        auto& previous = result();
+        bool have_previous = previous.size() == n;
+        std::vector<std::vector<size_t>> by_option(n);  // Token indices
+
+        for (size_t k = 0; k < scan.tokens.size(); ++k)
+            by_option[scan.tokens[k].first].push_back(k);
+
+        std::vector<size_t> changed;
+
+        for (size_t i = 0; i < n; ++i) {
+
+            // The previous result only holds the values a Bounded variable
+            // kept, so the new tokens are compared after the same filtering
+
+            auto& list = by_option[i];
+            size_t skip = 0;
+            size_t keep = list.size();
+            if (keep > calls_[i].bound) {
+                if (! calls_[i].keep_first)
+                    skip = keep - calls_[i].bound;
+                keep = calls_[i].bound;
+            }
+            bool same = have_previous ? previous.found(i) == (scan.found[i] != 0) && previous.values(i) == keep
+                    && previous.dropped(i) == list.size() - keep
+                : ! scan.found[i];
+            for (size_t j = 0; same && have_previous && j < keep; ++j)
+                same = previous.value(i, j) == scan.tokens[list[skip + j]].second;
+            if (! same)
+                changed.push_back(i);
+        }
+
+        // As in parse(), the error reported is the earliest on the command line
+
+        std::vector<std::deque<std::string>> owned(n);
+        parse_error first_error;
+
+        auto check = [&] (size_t i, size_t k, const std::string& value) {
+            auto& opt = options_[i];
+            auto& calls = calls_[i];
+            auto code = error_code::none;
+            if ((opt.is_utf8 || check_utf8_) && utf8_error(value) != npos)
+                code = error_code::invalid_encoding;
+            else if (calls.batch)
+                return;
+            else if (calls.validator && ! calls.validator(value))
+                code = error_code::pattern_mismatch;
+            else
+                code = calls.view_setter ? calls.view_setter(value, false) : calls.setter(value, false);
+            if (code != error_code::none && scan.indices[k] < first_error.index)
+                first_error = {code, scan.indices[k], name_of(i), value};
+        };
+
+        pool_scope pool;
+
+        for (auto i: changed) {
+            for (auto k: by_option[i]) {
+                owned[i].push_back(std::string(scan.tokens[k].second));
+                check(i, k, owned[i].back());
+            }
+            if (calls_[i].batch && ! owned[i].empty()) {
+                std::vector<const std::string*> values;
+                for (auto& value: owned[i])
+                    values.push_back(&value);
+                auto batch_errors = calls_[i].batch(values, true);
+                if (! batch_errors.empty()) {
+                    auto [pos, code] = batch_errors.front();
+                    if (scan.indices[by_option[i][pos]] < first_error.index)
+                        first_error = {code, scan.indices[by_option[i][pos]], name_of(i), *values[pos]};
+                }
+            }
+        }
+
+        if (first_error.index != npos)
+            throw user_error(error_message(first_error));
+
+        // Nothing below can fail
+
+        for (auto i: changed) {
+            auto& calls = calls_[i];
+            if (calls.reset)
+                calls.reset();
+            if (calls.batch && ! owned[i].empty()) {
+                std::vector<const std::string*> values;
+                for (auto& value: owned[i])
+                    values.push_back(&value);
+                calls.batch(values, false);
+            } else if (calls.view_setter) {
+                // The variable was reset, so nothing refers to the old copies
+                calls.view_store = std::make_shared<std::deque<std::string>>(
+                    std::make_move_iterator(owned[i].begin()), std::make_move_iterator(owned[i].end()));
+                for (auto& value: *calls.view_store)
+                    calls.view_setter(value, true);
+            } else {
+                for (auto& value: owned[i])
+                    calls.setter(value, true);
+            }
+        }
+
+        for (size_t i = 0; i < n; ++i)
+            options_[i].found = scan.found[i] != 0;
+
+        set_result(scan.found, scan.counts, scan.tokens);
+
+        return changed;
+
+    }
+
+    Options::event_range Options::events(const std::vector<std::string>& args) {
+        add_standard();
+        return event_range(*this, nullptr, args.data(), args.size());
+    }
+
+    Options::event_range Options::events(std::vector<std::string>&& args) {
+        // A temporary list is moved into the range so the events stay valid
+        auto owned = std::make_shared<const std::vector<std::string>>(std::move(args));
+        auto range = events(*owned);
+        range.owned_ = std::move(owned);
+        return range;
+    }
+
+    Options::event_range Options::events(int argc, char** argv) {
+        add_standard();
+        return event_range(*this, argv + 1, nullptr, argc < 1 ? 0 : size_t(argc - 1));
+    }
+
+    std::string Options::error_message(const parse_error& error) const {
+
+        switch (error.code) {
+
+            case error_code::none:
+                return {};
+
+            case error_code::ambiguous_option: {
+                auto [first, last] = index_.find(trim_name(error.argument.substr(2)), true);
+                std::vector<std::string> names;
+                for (auto it = first; it != last; ++it)
+                    names.push_back("--" + it->key);
+                return "Ambiguous option: {0:q} could be {1}"_fmt(error.argument, join(names, ", "));
+            }
+
+            case error_code::constraint_failed: {
+                size_t index = option_index(error.option);
+                std::string limits;
+                if (index != npos && calls_[index].constraint)
+                    limits = calls_[index].constraint();
+                return "Argument to --{0} is not {1}: {2:q}"_fmt(error.option, limits, error.argument);
+            }
+
+            case error_code::invalid_argument:
+                return "Invalid argument to --{0}: {1:q}"_fmt(error.option, error.argument);
+
+            case error_code::invalid_encoding:
+                return "Invalid UTF-8 in argument to --{0} at byte {1}: {2:q}"_fmt
+                    (error.option, utf8_error(error.argument), error.argument);
+
+            case error_code::invalid_option:
+                return "Invalid option: {0:q}"_fmt(error.argument);
+
+            case error_code::mutually_exclusive: {
+                size_t index = option_index(error.option);
+                uint16_t group = index == npos ? 0 : options_[index].group;
+                return "Options {0} are mutually exclusive"_fmt(group_list(group));
+            }
+
+            case error_code::pattern_mismatch: {
+                std::string message = "Argument does not match expected pattern: {0:q}"_fmt(error.argument);
+                size_t index = option_index(error.option);
+                if (index != npos && calls_[index].values) {
+                    auto match = closest_match(error.argument, calls_[index].values(), [] (auto& s) -> auto& { return s; });
+                    if (! match.empty())
+                        message += " (did you mean {0:q}?)"_fmt(match);
+                }
+                return message;
+            }
+
+            case error_code::repeated_option:
+                return "Repeated option: --" + error.option;
+
+            case error_code::required_missing:
+                return "Required option not found: --" + error.option;
+
+            case error_code::unassigned_argument:
+                return "Argument not associated with an option: {0:q}"_fmt(error.argument);
+
+            case error_code::unknown_option: {
+                std::string message = "Unknown option: {0:q}"_fmt(error.argument);
+                if (starts_with(error.argument, "--")) {
+                    auto match = index_.closest(trim_name(error.argument.substr(2)));
+                    if (! match.empty())
+                        message += " (did you mean {0:q}?)"_fmt("--" + match);
+                }
+                return message;
+            }
+
+            default:
+                return "Unknown error";
+
+        }
+
+    }
+
+    bool Options::found(const std::string& name) const {
+        auto i = option_index(name);
+        return i != npos && options_[i].found;
+    }
+
+    size_t Options::do_add(option_calls calls, const std::string& name, char abbrev, const std::string& description,
+            const std::string& placeholder, const std::string& pattern, mode kind, int flags, const std::string& group) {
+
+        // Binding a variable to an option loaded from a spec only fills in
+        // the functions; everything else was checked when the spec was saved
+
+        if (auto i = option_index(name); i != npos && options_[i].is_unbound) {
+            if (kind != options_[i].kind || placeholder != text(texts_[i].placeholder))
+                throw setup_error("Variable type does not match option: --" + name_of(i));
+            auto& old = calls_[i];
+            old.setter = std::move(calls.setter);
+            old.view_setter = std::move(calls.view_setter);
+            old.validator = std::move(calls.validator);
+            old.batch = std::move(calls.batch);
+            old.reset = std::move(calls.reset);
+            old.bound = calls.bound;
+            old.keep_first = calls.keep_first;
+            if (calls.default_value)
+                old.default_value = std::move(calls.default_value);
+            if (! old.values)
+                old.values = std::move(calls.values);
+            options_[i].is_unbound = false;
+            return i;
+        }
+
+        bool anon_complete = false;
+        option_info info;
+        auto trimmed_name = trim_name(name);
+        auto trimmed_description = trim(description);
+
+        info.hash = name_hash(trimmed_name);
+        info.abbrev = abbrev;
+        info.kind = kind;
+        info.is_anon = (flags & anon) != 0;
+        info.is_no_default = (flags & no_default) != 0;
+        info.is_parallel = (flags & parallel) != 0;
+        info.is_required = (flags & required) != 0;
+        info.is_utf8 = (flags & utf8) != 0;
+
+        if (trimmed_name.empty() || name.find_first_of(ascii_whitespace) != npos
+                || std::find_if(name.begin(), name.end(), ascii_iscntrl) != name.end())
+            throw setup_error("Invalid long option: " + name);
+        if (! allow_help_ && (name == "help" || name == "version"))
+            throw setup_error("Invalid long option: " + name);
+        if (option_index(trimmed_name) != npos)
+            throw setup_error("Duplicate long option: --" + trimmed_name);
+
+        if (info.abbrev != '\0') {
+            if (! ascii_isgraph(info.abbrev) || info.abbrev == '-')
+                throw setup_error("Invalid short option: -"s + info.abbrev);
+            if (option_index(info.abbrev) != npos)
+                throw setup_error("Duplicate short option: -"s + info.abbrev);
+        }
+
+        if ((flags & parallel) != 0 && info.kind != mode::multiple)
+            throw setup_error("Parallel conversion is only allowed for multi-valued options: --" + trimmed_name);
+        if (info.kind == mode::boolean && info.is_anon)
+            throw setup_error("Boolean options can't be anonymous: --" + trimmed_name);
+        if (info.kind == mode::boolean && info.is_required)
+            throw setup_error("Boolean options can't be required: --" + trimmed_name);
+
+        if (info.is_anon) {
+            if (anon_complete)
+                throw setup_error("All anonymous arguments are already accounted for: --" + trimmed_name);
+            anon_complete = info.kind == mode::multiple;
+        }
+
+        if (info.is_required && ! group.empty())
+            throw setup_error("Required options can't be in a mutual exclusion group: --" + trimmed_name);
+
+        if (trimmed_description.empty())
+            throw setup_error("Option description is empty: --" + trimmed_name);
+
+        info.group = add_group(group);
+
+        option_text refs;
+        refs.name = add_text(trimmed_name);
+        refs.description = add_text(trimmed_description);
+        refs.placeholder = add_text(placeholder, true);
+        refs.pattern = add_text(pattern);
+
+        options_.push_back(info);
+        texts_.push_back(refs);
+        calls_.push_back(std::move(calls));
+
+        // Options added after the standard ones (e.g. to a loaded spec)
+        // need the index rebuilt, which is left until it is next needed
+
+        if (allow_help_ && trimmed_name != "help" && trimmed_name != "version")
+            index_stale_ = true;
+
+        return options_.size() - 1;
+
+    }
+
+    Options::text_ref Options::add_text(std::string_view str, bool intern) {
+
+        // Placeholders are mostly the same few strings, so they are shared
+
+        if (str.empty())
+            return {};
+
+        if (intern)
+            if (auto it = placeholders_.find(std::string(str)); it != placeholders_.end())
+                return it->second;
+
+        if (arena_.size() + str.size() > std::numeric_limits<uint32_t>::max())
+            throw setup_error("Too much option text");
+
+        text_ref ref = {uint32_t(arena_.size()), uint32_t(str.size())};
+        arena_ += str;
+        if (intern)
+            placeholders_.insert({std::string(str), ref});
+        return ref;
+
+    }
+
+    uint16_t Options::add_group(const std::string& group) {
+        if (group.empty())
+            return 0;
+        for (size_t i = 0; i < groups_.size(); ++i)
+            if (text(groups_[i]) == group)
+                return uint16_t(i + 1);
+        if (groups_.size() >= std::numeric_limits<uint16_t>::max())
+            throw setup_error("Too many mutual exclusion groups");
+        groups_.push_back(add_text(group));
+        return uint16_t(groups_.size());
+    }
+
+    std::string Options::group_of(size_t i) const {
+        auto group = options_[i].group;
+        return group == 0 ? std::string() : std::string(text(groups_[group - 1]));
+    }
+
+    std::string Options::save_spec() {
+
+        // Functions can't be saved, so formatted text is saved instead, and
+        // the variables are attached again with bind() after loading
+
+        add_standard();
+
+        SpecWriter out;
+        out.data() += spec_magic;
+        out.u32(spec_version);
+        out.str(app_);
+        out.str(version_);
+        out.str(description_);
+        out.str(extra_);
+        out.u32(uint32_t(colour_));
+        out.u8(allow_prefix_);
+        out.u8(auto_help_);
+        out.u8(check_utf8_);
+        out.u32(uint32_t(options_.size()));
+
+        for (size_t i = 0; i < options_.size(); ++i) {
+            auto& refs = texts_[i];
+            auto& calls = calls_[i];
+            out.str(name_of(i));
+            out.str(std::string(text(refs.description)));
+            out.str(std::string(text(refs.placeholder)));
+            out.str(calls.default_value ? calls.default_value() : std::string());
+            out.str(calls.constraint ? calls.constraint() : std::string());
+            out.str(group_of(i));
+            out.str(std::string(text(refs.pattern)));
+            auto values = calls.values ? calls.values() : std::vector<std::string>();
+            out.u32(uint32_t(values.size()));
+            for (auto& value: values)
+                out.str(value);
+            out.u8(uint8_t(options_[i].abbrev));
+            out.u8(uint8_t(options_[i].kind));
+            out.u8(uint8_t(option_flags(i)));
+        }
+
+        out.u32(uint32_t(index_.entries_.size()));
+
+        for (auto& entry: index_.entries_) {
+            out.str(entry.key);
+            out.u32(uint32_t(entry.option));
+            out.u8(entry.invert);
+        }
+
+        out.u32(uint32_t(index_.nodes_.size()));
+
+        for (auto& node: index_.nodes_) {
+            out.u32(node.first);
+            out.u32(node.last);
+            out.u32(node.child_begin);
+            out.u32(node.child_end);
+            out.u8(uint8_t(node.label));
+        }
+
+        return std::move(out.data());
+
+    }
+
+    Options Options::load_spec(std::string_view spec) {
+
+        if (spec.substr(0, spec_magic.size()) != spec_magic)
+            throw setup_error("Not an option spec");
+
+        SpecReader in(spec.substr(spec_magic.size()));
+
+        auto version = in.u32();
+
+        if (version < 1 || version > spec_version)
+            throw setup_error("Unsupported option spec version");
+
+        Options opts;
+        opts.app_ = in.str();
+        opts.version_ = in.str();
+        opts.description_ = in.str();
+        opts.extra_ = in.str();
+        opts.colour_ = int(int32_t(in.u32()));
+        opts.allow_prefix_ = in.u8() != 0;
+        opts.auto_help_ = in.u8() != 0;
+        opts.check_utf8_ = version >= 2 && in.u8() != 0;
+        opts.allow_help_ = true;
+        size_t n = in.u32();
+        opts.options_.resize(n);
+        opts.texts_.resize(n);
+        opts.calls_.resize(n);
+
+        auto formatter = [] (std::string str) -> formatter_type {
+            if (str.empty())
+                return {};
+            return [str] { return str; };
+        };
+
+        for (size_t i = 0; i < n; ++i) {
+            auto& opt = opts.options_[i];
+            auto& refs = opts.texts_[i];
+            auto& calls = opts.calls_[i];
+            auto name = in.str();
+            opt.hash = name_hash(name);
+            refs.name = opts.add_text(name);
+            refs.description = opts.add_text(in.str());
+            refs.placeholder = opts.add_text(in.str(), true);
+            calls.default_value = formatter(in.str());
+            calls.constraint = formatter(in.str());
+            opt.group = opts.add_group(in.str());
+            refs.pattern = opts.add_text(in.str());
+            std::vector<std::string> values(in.u32());
+            for (auto& value: values)
+                value = in.str();
+            if (! values.empty())
+                calls.values = [values] { return values; };
+            opt.abbrev = char(in.u8());
+            opt.kind = mode(in.u8());
+            if (opt.kind > mode::multiple)
+                throw setup_error("Option spec is corrupt");
+            int flags = in.u8();
+            opt.is_anon = (flags & anon) != 0;
+            opt.is_no_default = (flags & no_default) != 0;
+            opt.is_parallel = (flags & parallel) != 0;
+            opt.is_required = (flags & required) != 0;
+            opt.is_utf8 = (flags & utf8) != 0;
+            if (name == "help" || name == "version")
+                calls.setter = [] (const std::string&, bool) { return error_code::none; };
+            else
+                opt.is_unbound = true;
+        }
+
+        opts.index_.entries_.resize(in.u32());
+
+        for (auto& entry: opts.index_.entries_) {
+            entry.key = in.str();
+            entry.option = in.u32();
+            entry.invert = in.u8() != 0;
+            if (entry.option >= opts.options_.size())
+                throw setup_error("Option spec is corrupt");
+        }
+
+        opts.index_.nodes_.resize(in.u32());
+
+        for (auto& node: opts.index_.nodes_) {
+            node.first = in.u32();
+            node.last = in.u32();
+            node.child_begin = in.u32();
+            node.child_end = in.u32();
+            node.label = char(in.u8());
+            if (node.first > node.last || node.last > opts.index_.entries_.size()
+                    || node.child_begin > node.child_end || node.child_end > opts.index_.nodes_.size())
+                throw setup_error("Option spec is corrupt");
+        }
+
+        if (! in.done() || opts.option_index("help") == npos || opts.option_index("version") == npos)
+            throw setup_error("Option spec is corrupt");
+
+        opts.placeholders_ = {};
+
+        return opts;
+
+    }
+
+    std::string Options::completion_script(shell_type shell, const std::string& command) const {
+
+        Options opts = *this;
+        opts.add_standard();
+
+        switch (shell) {
+            case shell_type::bash:  return opts.bash_script(command);
+            case shell_type::fish:  return opts.fish_script(command);
+            case shell_type::zsh:   return opts.zsh_script(command);
+            default:                return {};
+        }
+
+    }
+
+    void Options::add_standard() {
+        // Everything that uses the index calls this first
+        if (index_stale_) {
+            index_.build(*this);
+            index_stale_ = false;
+        }
+        if (allow_help_)
+            return;
+        allow_help_ = true;
+        char help_abbrev = option_index('h') == npos ? 'h' : '\0';
+        char version_abbrev = option_index('v') == npos ? 'v' : '\0';
+        // These are checked through the found flag, so the setters do nothing
+        option_calls calls;
+        calls.setter = [] (const std::string&, bool) { return error_code::none; };
+        do_add(calls, "help", help_abbrev, "Show usage information", {}, {}, mode::boolean, 0, {});
+        do_add(calls, "version", version_abbrev, "Show version information", {}, {}, mode::boolean, 0, {});
+        index_.build(*this);
+        placeholders_ = {};
+    }
+
+    bool Options::fast_exit(std::string_view arg, std::ostream& out) {
+
+        // A lone help or version request (typically from a health check) is
+        // answered before the arguments are copied or any option is touched.
+        // The short forms only count if they will belong to help or version.
+
+        auto is_standard = [this] (char abbrev, std::string_view name) {
+            auto i = option_index(abbrev);
+            return i == npos || text(texts_[i].name) == name;
+        };
+
+        std::string reply;
+        std::string name;
+
+        if (arg == "--version" || (arg == "-v" && is_standard('v', "version"))) {
+            reply = app_ + version_ + '\n';
+            name = "version";
+        } else if (arg == "--help" || (arg == "-h" && is_standard('h', "help"))) {
+            add_standard();
+            reply = format_help();
+            name = "help";
+        } else {
+            return false;
+        }
+
+        // Leave the same state behind as a full parse would
+
+        add_standard();
+        for (auto& opt: options_)
+            opt.found = false;
+        options_[option_index(name)].found = true;
+        result_ = {};
+        result_pending_ = true;
+        result_args_ = {std::string(arg)};
+
+        out.write(reply.data(), std::streamsize(reply.size()));
+        return true;
+
+    }
+
+    Options::error_code Options::set_view(size_t i, std::string_view value) const {
+
+        // A single valued option's variable no longer refers to its old copy
+        // once it is set again, so that is replaced; values for a container
+        // are added to its copies. Nothing is replaced if the setter fails.
+
+        auto& calls = calls_[i];
+
+        if (options_[i].kind != mode::multiple || ! calls.view_store) {
+            auto store = std::make_shared<std::deque<std::string>>(1, std::string(value));
+            auto code = calls.view_setter(store->back(), true);
+            if (code == error_code::none)
+                calls.view_store = std::move(store);
+            return code;
+        }
+
+        calls.view_store->emplace_back(value);
+        auto code = calls.view_setter(calls.view_store->back(), true);
+        if (code != error_code::none)
+            calls.view_store->pop_back();
+        return code;
+
+    }
+
+    std::vector<uint8_t> Options::parse_args(const std::vector<std::string>& args,
+            const std::vector<std::string_view>& views, bool dry_run, std::vector<parse_error>& errors,
+            token_scan* scan) const {
+
+        for (size_t i = 0; i < options_.size(); ++i)
+            if (options_[i].is_unbound)
+                throw setup_error("No variable was bound to option: --" + name_of(i));
+
+        // In a dry run, every error is recorded and parsing continues, but
+        // no setters are called. The options' found flags are returned, and
+        // set by the caller.
+        // A scan is a dry run that only collects the tokens, without
+        // checking or converting any arguments.
+
+        std::vector<uint8_t> found(options_.size(), 0);
+        std::vector<uint32_t> counts(options_.size(), 0);
+        std::vector<std::pair<uint32_t, std::string_view>> tokens;  // (option, argument)
+        std::vector<uint8_t> groups_found(groups_.size() + 1, 0);
+        const option_info* current = nullptr;
+        size_t arg_index = 0;
+        bool escaped = false;
+        bool skipping = false;
+
+        auto fail = [&errors,&arg_index] (error_code code, const std::string& option, const std::string& argument) {
+            errors.push_back({code, arg_index, option, argument});
+        };
+
+        auto on_match = [this,&current,&found,&counts,&groups_found,&fail] (const option_info& opt) {
+            size_t index = &opt - options_.data();
+            if (found[index] && opt.kind != mode::multiple)
+                fail(error_code::repeated_option, name_of(index), {});
+            if (opt.group != 0 && ! found[index]) {
+                if (groups_found[opt.group])
+                    fail(error_code::mutually_exclusive, name_of(index), {});
+                groups_found[opt.group] = 1;
+            }
+            found[index] = 1;
+            ++counts[index];
+            current = opt.kind == mode::boolean ? nullptr : &opt;
+        };
+
+        // Arguments to options with the parallel flag are only collected here;
+        // owned holds values split from --name=value so the pointers are stable
+
+        std::vector<std::vector<std::pair<const std::string*, size_t>>> pending(options_.size());
+        std::deque<std::string> owned;
+
+        // String views refer to the caller's copy of the argument, at the
+        // same offset as the value within args. If there are no views (the
+        // caller's arguments won't outlive the parse), tokens refer to args,
+        // and values for string_view targets are copied by set_view().
+
+        auto on_value = [this,&args,&current,&fail,&pending,&tokens,&views,&arg_index,dry_run,scan]
+                (const option_info& opt, const std::string& value, size_t offset) {
+            size_t index = &opt - options_.data();
+            auto& calls = calls_[index];
+            auto view = (views.empty() ? std::string_view(args[arg_index]) : views[arg_index]).substr(offset, value.size());
+            if (scan)
+                tokens.push_back({uint32_t(index), view});
+            if (scan)
+                scan->indices.push_back(arg_index);
+            else if ((opt.is_utf8 || check_utf8_) && utf8_error(value) != npos)
+                fail(error_code::invalid_encoding, name_of(index), value);
+            else if (calls.batch)
+                pending[index].push_back({&value, arg_index});
+            else if (calls.validator && ! calls.validator(value))
+                fail(error_code::pattern_mismatch, name_of(index), value);
+            else if (auto code = ! calls.view_setter ? calls.setter(value, ! dry_run)
+                        : views.empty() && ! dry_run ? set_view(index, view)
+                        : calls.view_setter(view, ! dry_run);
+                    code != error_code::none)
+                fail(code, name_of(index), value);
+            if (opt.kind != mode::multiple)
+                current = nullptr;
+        };
+
+        auto on_flag = [this,&tokens,&arg_index,dry_run,scan] (const option_info& opt, bool value) {
+            size_t index = &opt - options_.data();
+            std::string_view arg = value ? "t" : "f";
+            if (scan)
+                tokens.push_back({uint32_t(index), arg});
+            if (scan)
+                scan->indices.push_back(arg_index);
+            else
+                calls_[index].setter(std::string(arg), ! dry_run);
+        };
+
+        for (; arg_index < args.size() && (dry_run || errors.empty()); ++arg_index) {
+
+            const auto& arg = args[arg_index];
+
+            if (escaped || arg[0] != '-') {
+
+                // Argument to an option
+
+                if (skipping)
+                    continue;
+
+                if (current == nullptr) {
+                    auto it = std::find_if(options_.begin(), options_.end(), [&found,this] (auto& opt) {
+                        return opt.is_anon && (opt.kind == mode::multiple || ! found[&opt - options_.data()]);
+                    });
+                    if (it == options_.end()) {
+                        fail(error_code::unassigned_argument, {}, arg);
+                        continue;
+                    }
+                    on_match(*it);
+                }
+
+                on_value(*current, arg, 0);
+
+            } else if (arg == "--") {
+
+                // Remaining arguments can't be options
+
+                escaped = true;
+                skipping = false;
+
+            } else if (arg[1] == '-') {
+
+                // Long option name, optionally combined with a value
+
+                current = nullptr;
+                skipping = true;
+                size_t eq_pos = arg.find('=');
+
+                if (eq_pos != npos && eq_pos < 4) {
+                    fail(error_code::invalid_option, {}, arg);
+                    continue;
+                }
+
+                auto key = trim_name(arg.substr(2, eq_pos == npos ? npos : eq_pos - 2));
+                auto [first, last] = index_.find(key, allow_prefix_);
+
+                if (first == last) {
+                    fail(error_code::unknown_option, {}, arg.substr(0, eq_pos));
+                    continue;
+                } else if (last - first > 1) {
+                    fail(error_code::ambiguous_option, {}, arg.substr(0, eq_pos));
+                    continue;
+                }
+
+                skipping = false;
+                auto& opt = options_[first->option];
+                on_match(opt);
+
+                if (opt.kind == mode::boolean) {
+                    bool value = true;
+                    if (eq_pos != npos && ! parse_boolean(arg.substr(eq_pos + 1), value))
+                        fail(error_code::invalid_argument, name_of(first->option), arg.substr(eq_pos + 1));
+                    else
+                        on_flag(opt, value != first->invert);
+                } else if (eq_pos != npos) {
+                    owned.push_back(arg.substr(eq_pos + 1));
+                    on_value(opt, owned.back(), eq_pos + 1);
+                }
+
+            } else {
+
+                // One or more short option names
+
+                current = nullptr;
+                skipping = false;
+
+                if (arg.size() < 2)
+                    fail(error_code::unknown_option, {}, arg);
+
+                for (size_t i = 1; i < arg.size(); ++i) {
+                    size_t opt_index = option_index(arg[i]);
+                    if (opt_index == npos) {
+                        fail(error_code::unknown_option, {}, {'-', arg[i]});
+                        current = nullptr;
+                        skipping = true;
+                        break;
+                    }
+                    auto& opt = options_[opt_index];
+                    on_match(opt);
+                    if (opt.kind == mode::boolean)
+                        on_flag(opt, true);
+                }
+
+            }
+
+        }
+
+        // The batches only see arguments read before the serial loop stopped,
+        // but an error in a batch may still come before the one that stopped
+        // it. Once anything has failed, the remaining batches are only
+        // checked, and the errors are put back in command line order.
+
+        pool_scope pool;
+
+        for (size_t i = 0; i < options_.size(); ++i) {
+            if (pending[i].empty())
+                continue;
+            std::vector<const std::string*> values;
+            for (auto& [value, index]: pending[i])
+                values.push_back(value);
+            for (auto& [pos, code]: calls_[i].batch(values, dry_run || ! errors.empty())) {
+                arg_index = pending[i][pos].second;
+                fail(code, name_of(i), *values[pos]);
+            }
+        }
+
+        std::stable_sort(errors.begin(), errors.end(),
+            [] (const parse_error& a, const parse_error& b) { return a.index < b.index; });
+
+        if (scan) {
+            scan->found = found;
+            scan->counts = counts;
+            scan->tokens = std::move(tokens);
+        }
+
+        // Required options are not checked if help or version was requested
+
+        if ((! errors.empty() && ! dry_run) || found[option_index("help")] || found[option_index("version")])
+            return found;
+
+        arg_index = npos;
+
+        // A streamed option is checked after the stream has been read
+
+        for (size_t i = 0; i < options_.size() && (dry_run || errors.empty()); ++i)
+            if (options_[i].is_required && ! found[i] && i != stream_.option)
+                fail(error_code::required_missing, name_of(i), {});
 
-        allow_help_ = true;
-        char help_abbrev = option_index('h') == npos ? 'h' : '\0';
-        char version_abbrev = option_index('v') == npos ? 'v' : '\0';
-        bool want_help = false;
-        bool want_version = false;
-        add(want_help, "help", help_abbrev, "Show usage information");
-        add(want_version, "version", version_abbrev, "Show version information");
+        return found;
 
-        if (auto_help_ && args.empty()) {
-            out << format_help();
-            return false;
+    }
+
+    Options::event_range::event_range(const Options& owner, char** argv, const std::string* args, size_t size):
+    owner_(&owner), argv_(argv), args_(args), size_(size), found_(owner.options_.size(), 0) {}
+
+    Options::event_range::iterator Options::event_range::begin() {
+        if (! started_) {
+            started_ = true;
+            live_ = advance();
         }
+        return live_ ? iterator(this) : iterator();
+    }
 
-        std::set<std::string> groups_found;
-        option_info* current = nullptr;
-        size_t arg_index = 0;
-        bool escaped = false;
-        bool paired = false;
+    bool Options::event_range::advance() {
+
+        // This follows the same steps as the token loop in parse_args(), but
+        // stops after each occurrence instead of calling the setters. An
+        // option that expects an argument but doesn't get one is reported
+        // with an empty value when the next option (or the end) is reached.
+
+        auto& options = owner_->options_;
+
+        for (;;) {
+
+            if (short_pos_ != 0) {
+
+                // Within a group of short options
+
+                auto arg = this->arg(pos_);
+
+                if (short_pos_ == arg.size()) {
+                    short_pos_ = 0;
+                    ++pos_;
+                    continue;
+                }
+
+                if (waiting_) {
+                    waiting_ = false;
+                    return emit(current_, {}, current_index_);
+                }
+
+                size_t index = owner_->option_index(arg[short_pos_++]);
+                current_ = npos;
+
+                if (index == npos) {
+                    short_pos_ = 0;
+                    skipping_ = true;
+                    return fail(error_code::unknown_option, arg, pos_++);
+                }
+
+                found_[index] = 1;
+
+                if (options[index].kind == mode::boolean)
+                    return emit(index, "t", pos_);
+
+                current_ = index;
+                current_index_ = pos_;
+                waiting_ = true;
+                continue;
 
-        auto on_match = [this,&current,&groups_found,&paired] (option_info& opt) {
-            current = &opt;
-            if (opt.found && opt.kind != mode::multiple)
-                throw user_error("Repeated option: --" + opt.name);
-            if (! opt.group.empty()) {
-                if (groups_found.count(opt.group) == 1)
-                    throw user_error("Options {0} are mutually exclusive"_fmt(group_list(opt.group)));
-                groups_found.insert(opt.group);
-            }
-            opt.found = true;
-            if (opt.kind == mode::boolean && !paired) {
-                opt.setter("t");
-                current = nullptr;
             }
-        };
 
-        while (arg_index < args.size()) {
+            if (pos_ >= size_) {
+                if (! waiting_)
+                    return false;
+                waiting_ = false;
+                return emit(current_, {}, current_index_);
+            }
 
-            const auto& arg = args[arg_index];
+            auto arg = this->arg(pos_);
 
-            if (escaped || arg[0] != '-') {
+            if (escaped_ || arg.empty() || arg[0] != '-') {
 
                 // Argument to an option
 
-                if (current == nullptr) {
-                    auto it = std::find_if(options_.begin(), options_.end(), [] (auto& opt) {
-                        return opt.is_anon && (opt.kind == mode::multiple || ! opt.found);
+                size_t arg_index = pos_++;
+
+                if (skipping_)
+                    continue;
+
+                if (current_ == npos) {
+                    auto it = std::find_if(options.begin(), options.end(), [this,&options] (auto& opt) {
+                        return opt.is_anon && (opt.kind == mode::multiple || ! found_[&opt - options.data()]);
                     });
-                    if (it == options_.end())
-                        throw user_error("Argument not associated with an option: {0:q}"_fmt(arg));
-                    on_match(*it);
+                    if (it == options.end())
+                        return fail(error_code::unassigned_argument, arg, arg_index);
+                    current_ = it - options.begin();
+                    found_[current_] = 1;
                 }
 
-                if (current->validator && ! current->validator(arg))
-                    throw user_error("Argument does not match expected pattern: {0:q}"_fmt(arg));
+                size_t index = current_;
+                waiting_ = false;
+                if (options[index].kind != mode::multiple)
+                    current_ = npos;
+                return emit(index, arg, arg_index);
 
-                try {
-                    current->setter(arg);
-                }
-                catch (const std::invalid_argument& ex) {
-                    throw user_error(ex.what());
-                }
-                if (current->kind != mode::multiple)
-                    current = nullptr;
-                paired = false;
-                ++arg_index;
+            }
 
-            } else if (arg == "--") {
+            if (arg == "--") {
 
                 // Remaining arguments can't be options
 
-                escaped = true;
-                ++arg_index;
+                ++pos_;
+                escaped_ = true;
+                skipping_ = false;
+                continue;
 
-            } else if (arg[0] == '-' && arg[1] == '-') {
+            }
 
-                size_t eq_pos = arg.find('=');
+            if (waiting_) {
+                waiting_ = false;
+                return emit(current_, {}, current_index_);
+            }
 
-                if (eq_pos == npos) {
+            current_ = npos;
 
-                    // Long option name
+            if (arg.size() < 2) {
+                skipping_ = false;
+                return fail(error_code::unknown_option, arg, pos_++);
+            }
 
-                    size_t opt_index = npos;
-                    bool invert = false;
-                    if (starts_with(arg, "--no-")) {
-                        opt_index = option_index(arg.substr(5));
-                        if (opt_index != npos && options_[opt_index].kind == mode::boolean)
-                            invert = paired = true;
-                    }
-                    if (! invert) {
-                        opt_index = option_index(arg.substr(2));
-                        if (opt_index == npos)
-                            throw user_error("Unknown option: {0:q}"_fmt(arg));
-                    }
-                    on_match(options_[opt_index]);
-                    ++arg_index;
-                    if (invert)
-                        args.insert(args.begin() + arg_index, "f");
+            if (arg[1] != '-') {
+                short_pos_ = 1;
+                skipping_ = false;
+                continue;
+            }
 
-                } else if (eq_pos >= 4) {
+            // Long option name, optionally combined with a value
 
-                    // Long option name and value combined
+            size_t arg_index = pos_++;
+            size_t eq_pos = arg.find('=');
+            skipping_ = true;
 
-                    auto key = arg.substr(0, eq_pos);
-                    auto value = arg.substr(eq_pos + 1);
-                    args.erase(args.begin() + arg_index);
-                    args.insert(args.begin() + arg_index, key);
-                    args.insert(args.begin() + arg_index + 1, value);
-                    paired = true;
+            if (eq_pos != npos && eq_pos < 4)
+                return fail(error_code::invalid_option, arg, arg_index);
 
-                } else {
+            auto key = trim_name_view(arg.substr(2, eq_pos == npos ? npos : eq_pos - 2));
+            auto [first, last] = owner_->index_.find(key, owner_->allow_prefix_);
 
-                    throw user_error("Invalid option: {0:q}"_fmt(arg));
+            if (first == last)
+                return fail(error_code::unknown_option, arg.substr(0, eq_pos), arg_index);
+            else if (last - first > 1)
+                return fail(error_code::ambiguous_option, arg.substr(0, eq_pos), arg_index);
 
-                }
+            size_t index = first->option;
+            skipping_ = false;
+            found_[index] = 1;
+
+            if (options[index].kind == mode::boolean) {
+                bool value = true;
+                if (eq_pos != npos && ! parse_boolean(std::string(arg.substr(eq_pos + 1)), value))
+                    return fail(error_code::invalid_argument, arg.substr(eq_pos + 1), arg_index, index);
+                return emit(index, value != first->invert ? "t" : "f", arg_index);
+            }
 
-            } else if (arg.size() > 2) {
+            current_ = index;
+
+            if (eq_pos == npos) {
+                current_index_ = arg_index;
+                waiting_ = true;
+                continue;
+            }
+
+            if (options[index].kind != mode::multiple)
+                current_ = npos;
+
+            return emit(index, arg.substr(eq_pos + 1), arg_index);
+
+        }
+
+    }
 
-                // Multiple short options
+    bool Options::event_range::emit(size_t option, std::string_view value, size_t index) noexcept {
+        event_ = {option, owner_->text(owner_->texts_[option].name), value, index, error_code::none};
+        return true;
+    }
 
-                std::vector<std::string> new_args;
-                for (char c: arg.substr(1))
-                    new_args.push_back({'-', c});
-                auto it = args.begin() + arg_index;
-                args.erase(it);
-                args.insert(it, new_args.begin(), new_args.end());
+    bool Options::event_range::fail(error_code code, std::string_view value, size_t index, size_t option) noexcept {
+        event_ = {option, {}, value, index, code};
+        if (option != npos)
+            event_.name = owner_->text(owner_->texts_[option].name);
+        return true;
+    }
 
+    void Options::read_stream(size_t first_index, std::vector<parse_error>& errors) {
+
+        // Values are handled as each chunk arrives. The buffer only grows if
+        // a single value is longer than it; without a callback, a string_view
+        // target keeps its own copy of each value in the argument store.
+
+        auto& opt = options_[stream_.option];
+        auto& calls = calls_[stream_.option];
+        std::vector<char> buffer(stream_buffer_size);
+        std::string str;
+        size_t begin = 0;
+        size_t end = 0;
+        size_t count = 0;
+
+        auto on_value = [&] (std::string_view value) {
+            str.assign(value);
+            auto code = error_code::none;
+            if ((opt.is_utf8 || check_utf8_) && utf8_error(value) != npos) {
+                code = error_code::invalid_encoding;
+            } else if (calls.validator && ! calls.validator(str)) {
+                code = error_code::pattern_mismatch;
+            } else if (stream_.callback) {
+                code = calls.view_setter ? calls.view_setter(value, false) : calls.setter(str, false);
+            } else if (calls.view_setter) {
+                code = set_view(stream_.option, value);
             } else {
+                code = calls.setter(str, true);
+            }
+            if (code != error_code::none) {
+                errors.push_back({code, first_index + count, name_of(stream_.option), str});
+                return false;
+            }
+            if (stream_.callback)
+                stream_.callback(value);
+            opt.found = true;
+            ++count;
+            return true;
+        };
 
-                // Short option name
+        for (bool more = true; more;) {
 
-                paired = false;
-                size_t opt_index = option_index(arg[1]);
-                if (opt_index == npos)
-                    throw user_error("Unknown option: {0:q}"_fmt(arg));
-                on_match(options_[opt_index]);
-                ++arg_index;
+            if (begin > 0) {
+                std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+                end -= begin;
+                begin = 0;
+            }
 
+            if (end == buffer.size())
+                buffer.resize(2 * buffer.size());
+
+            auto bytes = read_some(stream_.fd, buffer.data() + end, buffer.size() - end);
+            more = bytes > 0;
+            end += bytes;
+
+            while (begin < end) {
+                auto ptr = static_cast<const char*>(std::memchr(buffer.data() + begin, stream_.delimiter, end - begin));
+                if (ptr == nullptr && more)
+                    break;
+                size_t stop = ptr == nullptr ? end : size_t(ptr - buffer.data());
+                std::string_view value(buffer.data() + begin, stop - begin);
+                begin = std::min(stop + 1, end);
+                if (! value.empty() && ! on_value(value))
+                    return;
             }
 
         }
 
-        size_t index = option_index("help");
-        if (options_[index].found) {
-            out << format_help();
-            return false;
+        if (opt.is_required && ! opt.found)
+            errors.push_back({error_code::required_missing, npos, name_of(stream_.option), {}});
+
+    }
+
+    const Options::parse_result& Options::result() const {
+
+        // Building the result means scanning the arguments of the last parse
+        // again, so this is only done if it is asked for
+
+        if (result_pending_) {
+            std::vector<parse_error> errors;
+            token_scan scan;
+            parse_args(result_args_, {}, true, errors, &scan);
+            set_result(scan.found, scan.counts, scan.tokens);
         }
 
-        index = option_index("version");
-        if (options_[index].found) {
-            out << app_ << version_ << "\n";
-            return false;
+        return result_;
+
+    }
+
+    void Options::set_result(const std::vector<uint8_t>& found, const std::vector<uint32_t>& counts,
+            const std::vector<std::pair<uint32_t, std::string_view>>& tokens) const {
+
+        // Arguments are bucketed by option, preserving their order
+
+        parse_result r;
+        size_t n = options_.size();
+        r.found_ = found;
+        r.counts_ = counts;
+        r.name_offsets_.reserve(n + 1);
+        r.first_token_.assign(n + 1, 0);
+
+        for (auto& refs: texts_) {
+            r.name_offsets_.push_back(r.names_.size());
+            r.names_ += text(refs.name);
         }
 
-        auto it = std::find_if(options_.begin(), options_.end(), [] (auto& opt) { return opt.is_required && ! opt.found; });
-        if (it != options_.end())
-            throw user_error("Required option not found: --" + it->name);
+        r.name_offsets_.push_back(r.names_.size());
+        r.sorted_.resize(n);
+        std::iota(r.sorted_.begin(), r.sorted_.end(), 0);
+        std::sort(r.sorted_.begin(), r.sorted_.end(),
+            [&r] (uint32_t a, uint32_t b) { return r.name(a) < r.name(b); });
+
+        // Bounded options keep only the values their variables kept, so the
+        // result stays the same size however often they are repeated
+
+        std::vector<std::pair<uint32_t, std::string_view>> kept;
+        auto* used = &tokens;
+
+        if (std::any_of(calls_.begin(), calls_.end(), [] (auto& c) { return c.bound != npos; })) {
+            std::vector<size_t> total(n, 0);
+            for (auto& token: tokens)
+                ++total[token.first];
+            r.dropped_.assign(n, 0);
+            std::vector<size_t> seen(n, 0);
+            for (auto& token: tokens) {
+                auto i = token.first;
+                auto& calls = calls_[i];
+                size_t pos = seen[i]++;
+                if (calls.bound == npos
+                        || (calls.keep_first && pos < calls.bound)
+                        || (! calls.keep_first && total[i] - pos <= calls.bound))
+                    kept.push_back(token);
+                else
+                    ++r.dropped_[i];
+            }
+            used = &kept;
+        }
 
-        return true;
+        std::vector<size_t> bytes(n + 1, 0);
 
-    }
+        for (auto& [option, arg]: *used) {
+            ++r.first_token_[option + 1];
+            bytes[option + 1] += arg.size();
+        }
 
-    bool Options::parse(int argc, char** argv, std::ostream& out) {
-        std::vector<std::string> args(argv + 1, argv + argc);
-        return parse(args, out);
-    }
+        for (size_t i = 0; i < n; ++i) {
+            r.first_token_[i + 1] += r.first_token_[i];
+            bytes[i + 1] += bytes[i];
+        }
+
+        std::vector<size_t> next(r.first_token_.begin(), r.first_token_.end() - 1);
+        std::vector<std::string_view> sorted_tokens(used->size());
+        r.tokens_.reserve(bytes[n]);
+        r.token_offsets_.reserve(used->size() + 1);
+
+        for (auto& [option, arg]: *used)
+            sorted_tokens[next[option]++] = arg;
+
+        for (auto& arg: sorted_tokens) {
+            r.token_offsets_.push_back(r.tokens_.size());
+            r.tokens_ += arg;
+        }
+
+        r.token_offsets_.push_back(r.tokens_.size());
+        result_ = std::move(r);
+        result_pending_ = false;
+        result_args_ = std::vector<std::string>();  // Tokens may refer to these, so they go last
 
-    bool Options::found(const std::string& name) const {
-        auto i = option_index(name);
-        return i != npos && options_[i].found;
     }
 
-    void Options::do_add(setter_type setter, validator_type validator, const std::string& name, char abbrev,
-            const std::string& description, const std::string& placeholder, const std::string& default_value,
-            mode kind, int flags, const std::string& group) {
+    std::string Options::complete(const std::vector<std::string>& words) const {
 
-        bool anon_complete = false;
-        option_info info;
+        // The last word is the one being completed (possibly empty)
 
-        info.setter = setter;
-        info.validator = validator;
-        info.name = trim_name(name);
-        info.description = trim(description);
-        info.placeholder = placeholder;
-        info.default_value = default_value;
-        info.group = group;
-        info.abbrev = abbrev;
-        info.kind = kind;
-        info.is_anon = (flags & anon) != 0;
-        info.is_no_default = (flags & no_default) != 0;
-        info.is_required = (flags & required) != 0;
+        std::string current = words.empty() ? std::string() : words.back();
+        std::string previous = words.size() < 2 ? std::string() : words[words.size() - 2];
+        std::string prefix;
+        size_t index = npos;
+        std::vector<std::string> matches;
 
-        std::string long_name = "--" + info.name;
-        std::string short_name = {'-', info.abbrev};
+        auto lookup_long = [this] (const std::string& name) -> size_t {
+            auto [first, last] = index_.find(name, allow_prefix_);
+            if (last - first != 1 || first->invert)
+                return npos;
+            return first->option;
+        };
 
-        if (info.name.empty() || name.find_first_of(ascii_whitespace) != npos
-                || std::find_if(name.begin(), name.end(), ascii_iscntrl) != name.end())
-            throw setup_error("Invalid long option: " + name);
-        if (! allow_help_ && (name == "help" || name == "version"))
-            throw setup_error("Invalid long option: " + name);
-        if (option_index(info.name) != npos)
-            throw setup_error("Duplicate long option: --" + info.name);
+        if (starts_with(current, "--") && current.find('=') != npos) {
+            size_t eq_pos = current.find('=');
+            prefix = current.substr(0, eq_pos + 1);
+            index = lookup_long(current.substr(2, eq_pos - 2));
+            current.erase(0, eq_pos + 1);
+        } else if (current == "-" || starts_with(current, "--")) {
+            auto [first, last] = index_.complete(current.substr(std::min(current.size(), size_t(2))));
+            for (auto it = first; it != last; ++it)
+                matches.push_back("--" + it->key);
+        } else if (starts_with(previous, "--")) {
+            index = lookup_long(previous.substr(2));
+        } else if (previous.size() == 2 && previous[0] == '-') {
+            index = option_index(previous[1]);
+        }
 
-        if (info.abbrev != '\0') {
-            if (! ascii_isgraph(info.abbrev) || info.abbrev == '-')
-                throw setup_error("Invalid short option: -"s + info.abbrev);
-            if (option_index(info.abbrev) != npos)
-                throw setup_error("Duplicate short option: -"s + info.abbrev);
+        if (index != npos && options_[index].kind != mode::boolean && calls_[index].values)
+            for (auto& value: calls_[index].values())
+                if (starts_with(value, current))
+                    matches.push_back(prefix + value);
+
+        std::string text;
+        for (auto& match: matches)
+            text += match + '\n';
+        return text;
+
+    }
+
+    std::string Options::bash_script(const std::string& command) const {
+
+        std::string function = "_" + shell_name(command) + "_complete";
+        std::vector<std::string> names;
+        std::string value_cases;
+
+        for (size_t i = 0; i < options_.size(); ++i) {
+            auto& info = options_[i];
+            auto& values = calls_[i].values;
+            auto name = name_of(i);
+            names.push_back("--" + name);
+            if (info.kind == mode::boolean && ! info.is_anon)
+                names.push_back("--no-" + name);
+            if (info.kind != mode::boolean && values) {
+                std::string pattern = "--" + name;
+                if (info.abbrev != '\0')
+                    pattern += "|-" + shell_quote(std::string{info.abbrev});
+                value_cases += "        {0})\n"
+                    "            COMPREPLY=($(compgen -W {1} -- \"$cur\"))\n"
+                    "            return\n"
+                    "            ;;\n"_fmt(pattern, shell_quote(join(values(), " ")));
+            }
         }
 
-        if (info.kind == mode::boolean && info.is_anon)
-            throw setup_error("Boolean options can't be anonymous: --" + info.name);
-        if (info.kind == mode::boolean && info.is_required)
-            throw setup_error("Boolean options can't be required: --" + info.name);
+        return function + "() {\n"
+            "    local cur=\"${COMP_WORDS[COMP_CWORD]}\"\n"
+            "    local prev=\"${COMP_WORDS[COMP_CWORD-1]}\"\n"
+            "    case \"$prev\" in\n"
+            + value_cases +
+            "    esac\n"
+            "    if [[ \"$cur\" == -* ]]; then\n"
+            "        COMPREPLY=($(compgen -W " + shell_quote(join(names, " ")) + " -- \"$cur\"))\n"
+            "    fi\n"
+            "}\n"
+            "complete -o default -F " + function + " " + shell_quote(command) + "\n";
 
-        if (info.is_anon) {
-            if (anon_complete)
-                throw setup_error("All anonymous arguments are already accounted for: --" + info.name);
-            anon_complete = info.kind == mode::multiple;
+    }
+
+    std::string Options::fish_script(const std::string& command) const {
+
+        std::string text;
+
+        for (size_t i = 0; i < options_.size(); ++i) {
+            auto& info = options_[i];
+            auto& values = calls_[i].values;
+            text += "complete -c " + fish_quote(command) + " -l " + fish_quote(name_of(i));
+            if (info.abbrev != '\0')
+                text += " -s " + fish_quote(std::string{info.abbrev});
+            if (info.kind != mode::boolean && values)
+                text += " -x -a " + fish_quote(join(values(), " "));
+            else if (info.kind != mode::boolean)
+                text += " -r";
+            text += " -d " + fish_quote(std::string(this->text(texts_[i].description))) + "\n";
         }
 
-        if (info.is_required && ! group.empty())
-            throw setup_error("Required options can't be in a mutual exclusion group: --" + info.name);
+        return text;
+
+    }
 
-        if (info.description.empty())
-            throw setup_error("Option description is empty: --" + info.name);
+    std::string Options::zsh_script(const std::string& command) const {
 
-        options_.push_back(info);
+        std::string text = "#compdef " + command + "\n\n_arguments -s";
+
+        for (size_t i = 0; i < options_.size(); ++i) {
+            auto& info = options_[i];
+            auto& values = calls_[i].values;
+            std::string placeholder(this->text(texts_[i].placeholder));
+            std::string spec = "[" + zsh_escape(std::string(this->text(texts_[i].description))) + "]";
+            if (info.kind != mode::boolean) {
+                spec += ":" + zsh_escape(placeholder) + ":";
+                if (values)
+                    spec += "(" + join(values(), " ") + ")";
+                else if (placeholder == "<arg>")
+                    spec += "_files";
+                else
+                    spec += " ";
+            }
+            std::string repeat = info.kind == mode::multiple ? "*" : "";
+            text += " \\\n    " + shell_quote(repeat + "--" + name_of(i) + spec);
+            if (info.abbrev != '\0')
+                text += " \\\n    " + shell_quote(repeat + "-" + info.abbrev + spec);
+        }
+
+        text += "\n";
+        return text;
 
     }
 
@@ -291,41 +2161,49 @@ namespace RS::Option {
         std::string block;
         size_t left_width = 0;
 
-        for (auto& info: options_) {
+        for (size_t i = 0; i < options_.size(); ++i) {
 
+            auto& info = options_[i];
+            auto& calls = calls_[i];
             block.clear();
 
             if (info.is_anon)
                 block += '[';
-            block += "--" + info.name;
+            block += "--" + name_of(i);
             if (info.abbrev != '\0')
                 block += ", -" + std::string{info.abbrev};
             if (info.is_anon)
                 block += ']';
 
             if (info.kind != mode::boolean) {
-                block += " " + info.placeholder;
+                block += " ";
+                block += this->text(texts_[i].placeholder);
                 if (info.kind == mode::multiple)
                     block += " ...";
             }
 
             left.push_back(block);
             left_width = std::max(left_width, block.size());
-            block = info.description;
-            bool show_default = ! info.is_no_default && ! info.default_value.empty();
-
-            if (info.is_required || show_default) {
+            block = this->text(texts_[i].description);
+            std::string default_value;
+            if (! info.is_no_default && calls.default_value)
+                default_value = calls.default_value();
+            std::vector<std::string> notes;
+            if (calls.constraint)
+                notes.push_back(calls.constraint());
+            if (info.is_required)
+                notes.push_back("required");
+            else if (! default_value.empty())
+                notes.push_back("default " + default_value);
+
+            if (! notes.empty()) {
                 if (block.back() == ')') {
                     block.pop_back();
                     block += "; ";
                 } else {
                     block += " (";
                 }
-                if (info.is_required)
-                    block += "required";
-                else if (show_default)
-                    block += "default " + info.default_value;
-                block += ")";
+                block += join(notes, "; ") + ")";
             }
 
             right.push_back(block);
@@ -346,19 +2224,36 @@ namespace RS::Option {
 
     }
 
-    std::string Options::group_list(const std::string& group) const {
+    std::string Options::group_list(uint16_t group) const {
         std::vector<std::string> names;
-        for (auto& info: options_)
-            if (info.group == group)
-                names.push_back("--" + info.name);
+        for (size_t i = 0; i < options_.size(); ++i)
+            if (group != 0 && options_[i].group == group)
+                names.push_back("--" + name_of(i));
         return join(names, ", ");
     }
 
+    size_t Options::unbound_option(const std::string& name) const {
+        auto i = option_index(name);
+        if (i == npos)
+            throw setup_error("Unknown option: --" + trim_name(name));
+        if (! options_[i].is_unbound)
+            throw setup_error("Option is already bound: --" + name_of(i));
+        return i;
+    }
+
+    int Options::option_flags(size_t i) const noexcept {
+        auto& opt = options_[i];
+        return (opt.is_anon ? anon : 0) | (opt.is_no_default ? no_default : 0)
+            | (opt.is_parallel ? parallel : 0) | (opt.is_required ? required : 0) | (opt.is_utf8 ? utf8 : 0);
+    }
+
     size_t Options::option_index(const std::string& name) const {
         auto key = trim_name(name);
-        auto it = std::find_if(options_.begin(), options_.end(),
-            [&key] (const option_info& opt) { return opt.name == key; });;
-        return it == options_.end() ? npos : size_t(it - options_.begin());
+        auto hash = name_hash(key);
+        for (size_t i = 0; i < options_.size(); ++i)
+            if (options_[i].hash == hash && text(texts_[i].name) == key)
+                return i;
+        return npos;
     }
 
     size_t Options::option_index(char abbrev) const {
@@ -369,4 +2264,274 @@ namespace RS::Option {
         return it == options_.end() ? npos : size_t(it - options_.begin());
     }
 
+    void Options::name_index::build(const Options& options) {
+
+        entries_.clear();
+        nodes_.clear();
+
+        for (size_t i = 0; i < options.options_.size(); ++i) {
+            entries_.push_back({options.name_of(i), i, false});
+            if (options.options_[i].kind == mode::boolean)
+                entries_.push_back({"no-" + options.name_of(i), i, true});
+        }
+
+        // If an option's actual name clashes with the inverted form of a
+        // boolean option, the inverted form takes priority
+
+        std::sort(entries_.begin(), entries_.end(), [] (const entry& a, const entry& b) {
+            return a.key == b.key ? a.invert && ! b.invert : a.key < b.key;
+        });
+        entries_.erase(std::unique(entries_.begin(), entries_.end(),
+            [] (const entry& a, const entry& b) { return a.key == b.key; }), entries_.end());
+
+        // Breadth first, so each node's children are contiguous
+
+        nodes_.push_back({0, uint32_t(entries_.size()), 0, 0, '\0'});
+
+        for (size_t i = 0, depth_end = 1, depth = 0; i < nodes_.size(); ++i) {
+            if (i == depth_end) {
+                depth_end = nodes_.size();
+                ++depth;
+            }
+            auto first = nodes_[i].first;
+            auto last = nodes_[i].last;
+            nodes_[i].child_begin = uint32_t(nodes_.size());
+            if (first < last && entries_[first].key.size() == depth)
+                ++first;
+            while (first < last) {
+                char c = entries_[first].key[depth];
+                auto next = first + 1;
+                while (next < last && entries_[next].key[depth] == c)
+                    ++next;
+                nodes_.push_back({first, next, 0, 0, c});
+                first = next;
+            }
+            nodes_[i].child_end = uint32_t(nodes_.size());
+        }
+
+    }
+
+    std::pair<const Options::name_index::entry*, const Options::name_index::entry*>
+    Options::name_index::find(std::string_view key, bool prefix) const {
+
+        auto [first, last] = complete(key);
+
+        // An exact match always wins, even if it's also a prefix of other names
+
+        if (first == last)
+            return {first, last};
+        else if (first->key.size() == key.size())
+            return {first, first + 1};
+        else if (prefix && ! key.empty())
+            return {first, last};
+        else
+            return {first, first};
+
+    }
+
+    std::pair<const Options::name_index::entry*, const Options::name_index::entry*>
+    Options::name_index::complete(std::string_view prefix) const {
+
+        const entry* none = entries_.data();
+
+        if (entries_.empty())
+            return {none, none};
+
+        const node* current = &nodes_[0];
+
+        for (char c: prefix) {
+            auto begin = nodes_.begin() + current->child_begin;
+            auto end = nodes_.begin() + current->child_end;
+            auto it = std::lower_bound(begin, end, c, [] (const node& n, char label) { return n.label < label; });
+            if (it == end || it->label != c)
+                return {none, none};
+            current = &*it;
+        }
+
+        return {entries_.data() + current->first, entries_.data() + current->last};
+
+    }
+
+    std::string Options::name_index::closest(const std::string& key) const {
+        return closest_match(key, entries_, [] (const entry& e) -> auto& { return e.key; });
+    }
+
+    bool Options::parse_boolean(const std::string& arg, bool& b) noexcept {
+
+        static constexpr std::pair<const char*, bool> names[] = {
+            {"0", false}, {"1", true}, {"f", false}, {"false", false}, {"n", false}, {"no", false},
+            {"off", false}, {"on", true}, {"t", true}, {"true", true}, {"y", true}, {"yes", true},
+        };
+
+        char key[8] = {};
+        if (arg.size() >= sizeof(key))
+            return false;
+        for (size_t i = 0; i < arg.size(); ++i)
+            key[i] = arg[i] >= 'A' && arg[i] <= 'Z' ? char(arg[i] - 'A' + 'a') : arg[i];
+
+        for (auto& [name, value]: names) {
+            if (std::strcmp(name, key) == 0) {
+                b = value;
+                return true;
+            }
+        }
+
+        return false;
+
+    }
+
+    Options::setter_type Options::make_setter(void* var, check_pointer check, convert_function convert) {
+        return [var,check,convert] (const std::string& str, bool commit) {
+            return convert(var, check.get(), str, commit);
+        };
+    }
+
+    std::vector<Options::batch_error> Options::run_batch(const std::vector<const std::string*>& args, bool dry_run,
+            const validator_type& validator, const void* check, void* values, element_function convert) {
+
+        // Arguments are validated and converted in parallel chunks. Each
+        // chunk stops at its first error, so the earliest error is always
+        // found.
+
+        std::vector<error_code> codes(args.size(), error_code::none);
+
+        run_parallel(args.size(), [&] (size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                if (validator && ! validator(*args[i]))
+                    codes[i] = error_code::pattern_mismatch;
+                else
+                    codes[i] = convert(values, check, i, *args[i]);
+                if (codes[i] != error_code::none && ! dry_run)
+                    break;
+            }
+        });
+
+        std::vector<batch_error> errors;
+        for (size_t i = 0; i < codes.size(); ++i)
+            if (codes[i] != error_code::none)
+                errors.push_back({i, codes[i]});
+        return errors;
+
+    }
+
+    Options::validator_type Options::numeric_validator(numeric type) {
+        return [type] (const std::string& str) { return match_numeric(type, str); };
+    }
+
+    Options::validator_type Options::name_validator(const std::vector<std::string>& names) {
+        // The list is the enumeration's own static list of names
+        return [&names] (const std::string& str) { return std::find(names.begin(), names.end(), str) != names.end(); };
+    }
+
+    Options::validator_type Options::pattern_validator(const std::string& name, const std::string& pattern, bool is_string) const {
+
+        if (pattern.empty())
+            return {};
+        if (! is_string)
+            throw setup_error("Pattern is only allowed for string-valued options: {0:q}"_fmt("--" + name));
+
+        // A pattern loaded from a spec was checked when the spec was saved,
+        // so bind() defers compiling it until first use; batches may call
+        // the validator from several threads at once
+
+        if (auto i = option_index(name); i != npos && options_[i].is_unbound) {
+            struct compiled {
+                std::string pattern;
+                std::once_flag once;
+                Regex re;
+            };
+            auto shared = std::make_shared<compiled>();
+            shared->pattern = pattern;
+            return [shared] (const std::string& str) {
+                std::call_once(shared->once, [&] { shared->re = Regex(shared->pattern, Regex::full | Regex::no_capture); });
+                return shared->re(str).matched();
+            };
+        }
+
+        // Built-in validators are compiled on first use; only an explicit
+        // pattern is compiled here, so that errors are reported by add()
+
+        Regex re;
+
+        try {
+            re = Regex(pattern, Regex::full | Regex::no_capture);
+        }
+        catch (const Regex::error& ex) {
+            throw setup_error(ex.what());
+        }
+
+        return [re] (const std::string& str) { return re(str).matched(); };
+
+    }
+
+    Options::values_type Options::name_values(const std::vector<std::string>& names) {
+        return [&names] { return names; };
+    }
+
+    void Options::run_parallel(size_t n, const std::function<void(size_t, size_t)>& fn) {
+
+        // Small batches aren't worth the cost of starting threads
+
+        static constexpr size_t min_chunk = 4096;
+
+        size_t chunks = std::min(worker_pool::capacity(), (n + min_chunk - 1) / min_chunk);
+
+        if (chunks <= 1) {
+            fn(0, n);
+            return;
+        }
+
+        size_t chunk_size = (n + chunks - 1) / chunks;
+        std::exception_ptr error;
+        std::mutex error_mutex;
+
+        std::function<void(size_t)> work = [&] (size_t i) {
+            try {
+                fn(i * chunk_size, std::min((i + 1) * chunk_size, n));
+            }
+            catch (...) {
+                std::unique_lock lock(error_mutex);
+                if (! error)
+                    error = std::current_exception();
+            }
+        };
+
+        // Outside a parse, a temporary pool is used
+
+        if (current_pool) {
+            current_pool->run(chunks, work);
+        } else {
+            worker_pool pool;
+            pool.run(chunks, work);
+        }
+
+        if (error)
+            std::rethrow_exception(error);
+
+    }
+
+    bool Options::match_numeric(numeric type, const std::string& str) {
+
+        // Each regex is compiled the first time an argument of that type is
+        // seen, and then shared by every option of that type
+
+        switch (type) {
+            case numeric::signed_integer: {
+                static const Regex re(R"([+-]?\d+)", Regex::full | Regex::no_capture);
+                return re(str).matched();
+            }
+            case numeric::unsigned_integer: {
+                static const Regex re(R"(\+?\d+)", Regex::full | Regex::no_capture);
+                return re(str).matched();
+            }
+            case numeric::floating: {
+                static const Regex re(R"([+-]?(\d+(\.\d*)?|\.\d+)([Ee][+-]?\d+)?)", Regex::full | Regex::no_capture);
+                return re(str).matched();
+            }
+            default:
+                return false;
+        }
+
+    }
+
 }
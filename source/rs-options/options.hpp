@@ -5,18 +5,41 @@
 #include "rs-regex/regex.hpp"
 #include "rs-tl/enum.hpp"
 #include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <functional>
+#include <initializer_list>
 #include <iostream>
 #include <iterator>
+#include <memory>
+#include <optional>
 #include <ostream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
 namespace RS::Option {
 
+    template <typename T> class Bounded;
+    template <typename T> class Lazy;
+    template <typename T> class RangeSet;
+
+    // Specialise this to parse a user defined type without going through
+    // an integer or string constructor. Required member:
+    //     static bool parse(std::string_view str, T& t) noexcept;
+    // Optional members:
+    //     static constexpr const char* placeholder;
+    //     static bool validate(std::string_view str) noexcept;
+
+    template <typename T> struct OptionTraits {};
+
     namespace Detail {
 
         template <typename T, typename = void> struct HasBackInserter: std::false_type {};
@@ -30,35 +53,574 @@ namespace RS::Option {
         template <typename T, bool = HasValueType<T>::value> struct ValueType { using type = void; };
         template <typename T> struct ValueType<T, true> { using type = typename T::value_type; };
 
-        template <typename T> constexpr bool is_scalar_argument_type = (
-            std::is_arithmetic_v<T>
+        template <typename T> constexpr bool is_string_type =
+            std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>;
+
+        template <typename T, typename = void> struct HasOptionTraits: std::false_type {};
+        template <typename T> struct HasOptionTraits<T,
+            std::void_t<decltype(OptionTraits<T>::parse(std::declval<std::string_view>(), std::declval<T&>()))>>:
+            std::true_type {};
+
+        template <typename T, typename = void> struct HasTraitsPlaceholder: std::false_type {};
+        template <typename T> struct HasTraitsPlaceholder<T, std::void_t<decltype(OptionTraits<T>::placeholder)>>:
+            std::true_type {};
+
+        template <typename T, typename = void> struct HasTraitsValidator: std::false_type {};
+        template <typename T> struct HasTraitsValidator<T,
+            std::void_t<decltype(OptionTraits<T>::validate(std::declval<std::string_view>()))>>:
+            std::true_type {};
+
+        template <typename T> struct IsLazy: std::false_type {};
+        template <typename T> struct IsLazy<Lazy<T>>: std::true_type {};
+
+        template <typename T> constexpr bool is_scalar_argument_type = ! IsLazy<T>::value && (
+            HasOptionTraits<T>::value
+            || std::is_arithmetic_v<T>
             || std::is_enum_v<T>
             || std::is_same_v<T, std::string>
+            || std::is_same_v<T, std::string_view>
             || (! HasBackInserter<T>::value
                 && (std::is_constructible_v<T, int>
                     || std::is_constructible_v<T, std::string>))
         );
 
+        template <typename T> struct IsBounded: std::false_type {};
+        template <typename T> struct IsBounded<Bounded<T>>: std::true_type {};
+
+        template <typename T> struct IsRangeSet: std::false_type {};
+        template <typename T> struct IsRangeSet<RangeSet<T>>: std::true_type {};
+
         template <typename T> constexpr bool is_container_argument_type = (
             HasBackInserter<T>::value
             && is_scalar_argument_type<typename ValueType<T>::type>
-            && ! std::is_same_v<T, std::string>
+            && ! is_string_type<T>
+            && ! IsRangeSet<T>::value
         );
 
         template <typename T> constexpr bool is_valid_argument_type = (
             is_scalar_argument_type<T>
             || is_container_argument_type<T>
+            || IsRangeSet<T>::value
+            || IsLazy<T>::value
         );
 
+        template <typename T, typename = void> struct HasLessThan: std::false_type {};
+        template <typename T> struct HasLessThan<T,
+            std::void_t<decltype(std::declval<const T&>() < std::declval<const T&>())>>:
+            std::true_type {};
+
+        template <typename T, typename = void> struct HasHash: std::false_type {};
+        template <typename T> struct HasHash<T, std::void_t<decltype(std::hash<T>()(std::declval<const T&>()))>>:
+            std::true_type {};
+
+    }
+
+    // A sequence holding at most a fixed number of values, for options that
+    // may be repeated many times. Once full, either the oldest value is
+    // overwritten (keep last) or new values are discarded (keep first);
+    // either way insertion takes constant time and nothing is reallocated.
+
+    template <typename T>
+    class Bounded {
+
+    public:
+
+        enum policy: int {
+            first,  // Keep the first values, discard later ones
+            last,   // Keep the most recent values, discard older ones
+        };
+
+        using value_type = T;
+
+        class const_iterator {
+        public:
+            using difference_type = ptrdiff_t;
+            using iterator_category = std::forward_iterator_tag;
+            using pointer = const T*;
+            using reference = const T&;
+            using value_type = T;
+            const_iterator() = default;
+            const T& operator*() const noexcept { return (*owner_)[index_]; }
+            const T* operator->() const noexcept { return &**this; }
+            const_iterator& operator++() noexcept { ++index_; return *this; }
+            const_iterator operator++(int) noexcept { auto i = *this; ++*this; return i; }
+            bool operator==(const const_iterator& i) const noexcept { return index_ == i.index_; }
+            bool operator!=(const const_iterator& i) const noexcept { return ! (*this == i); }
+        private:
+            friend class Bounded;
+            const Bounded* owner_ = nullptr;
+            size_t index_ = 0;
+            const_iterator(const Bounded* owner, size_t index) noexcept: owner_(owner), index_(index) {}
+        };
+
+        using iterator = const_iterator;
+
+        Bounded() = default;
+        explicit Bounded(size_t capacity, policy keep = last): capacity_(capacity), keep_(keep) { values_.reserve(capacity); }
+
+        const T& operator[](size_t i) const noexcept { return values_[(head_ + i) % values_.size()]; }
+        const_iterator begin() const noexcept { return {this, 0}; }
+        const_iterator end() const noexcept { return {this, values_.size()}; }
+        const T& front() const noexcept { return (*this)[0]; }
+        const T& back() const noexcept { return (*this)[values_.size() - 1]; }
+        size_t capacity() const noexcept { return capacity_; }
+        void clear() noexcept { values_.clear(); head_ = 0; dropped_ = 0; }
+        size_t dropped() const noexcept { return dropped_; }
+        bool empty() const noexcept { return values_.empty(); }
+        policy keep() const noexcept { return keep_; }
+        size_t size() const noexcept { return values_.size(); }
+        // Insertion ignores the position: values are always appended
+        void push_back(const T& t) { push(t); }
+        void push_back(T&& t) { push(std::move(t)); }
+        iterator insert(const_iterator /*pos*/, const T& t) { push(t); return end(); }
+        iterator insert(const_iterator /*pos*/, T&& t) { push(std::move(t)); return end(); }
+
+        friend bool operator==(const Bounded& a, const Bounded& b) noexcept {
+            return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+        }
+        friend bool operator!=(const Bounded& a, const Bounded& b) noexcept { return ! (a == b); }
+
+    private:
+
+        std::vector<T> values_;  // Circular once full, oldest at head_
+        size_t capacity_ = 0;
+        size_t head_ = 0;
+        size_t dropped_ = 0;
+        policy keep_ = last;
+
+        template <typename U> void push(U&& u);
+
+    };
+
         template <typename T>
-        T parse_enum_unchecked(const std::string& arg) {
-            // The string has already been validated
-            T t = {};
-            parse_enum(arg, t);
-            return t;
+        template <typename U>
+        void Bounded<T>::push(U&& u) {
+            if (values_.size() < capacity_) {
+                values_.push_back(std::forward<U>(u));
+            } else {
+                ++dropped_;
+                if (keep_ == last && capacity_ != 0) {
+                    values_[head_] = std::forward<U>(u);
+                    head_ = (head_ + 1) % capacity_;
+                }
+            }
         }
 
-    }
+    // Constraints are checked against the converted value, after the
+    // argument has passed any syntax check
+
+    template <typename T>
+    class Constraint {
+
+    public:
+
+        Constraint() = default;
+
+        static Constraint range(const T& min, const T& max) { return limits(min, max); }
+        static Constraint at_least(const T& min) { return limits(min, std::nullopt); }
+        static Constraint at_most(const T& max) { return limits(std::nullopt, max); }
+        static Constraint one_of(std::initializer_list<T> list);
+        static Constraint length(size_t min, size_t max = std::string::npos);
+
+        bool operator()(const T& t) const;
+        bool operator()(const T& min, const T& max) const;
+        std::string str() const;
+        std::vector<std::string> values() const;
+
+    private:
+
+        std::optional<T> min_;
+        std::optional<T> max_;
+        std::shared_ptr<const std::unordered_set<T>> set_;
+        std::vector<T> list_;  // Original order, for display
+        size_t min_length_ = 0;
+        size_t max_length_ = std::string::npos;
+
+        static Constraint limits(std::optional<T> min, std::optional<T> max);
+        static std::string format_value(const T& t);
+
+    };
+
+        template <typename T>
+        Constraint<T> Constraint<T>::one_of(std::initializer_list<T> list) {
+            static_assert(Detail::HasHash<T>::value, "Constraint::one_of() requires a hashable type");
+            Constraint c;
+            c.set_ = std::make_shared<std::unordered_set<T>>(list.begin(), list.end());
+            c.list_ = list;
+            return c;
+        }
+
+        template <typename T>
+        Constraint<T> Constraint<T>::length(size_t min, size_t max) {
+            static_assert(Detail::is_string_type<T>, "Constraint::length() requires a string type");
+            Constraint c;
+            c.min_length_ = min;
+            c.max_length_ = max;
+            return c;
+        }
+
+        template <typename T>
+        bool Constraint<T>::operator()(const T& t) const {
+            if constexpr (Detail::HasLessThan<T>::value) {
+                if (min_ && t < *min_)
+                    return false;
+                if (max_ && *max_ < t)
+                    return false;
+            }
+            if constexpr (Detail::is_string_type<T>)
+                if (t.size() < min_length_ || t.size() > max_length_)
+                    return false;
+            if constexpr (Detail::HasHash<T>::value)
+                if (set_ && set_->count(t) == 0)
+                    return false;
+            return true;
+        }
+
+        template <typename T>
+        bool Constraint<T>::operator()(const T& min, const T& max) const {
+            // True if every value in the closed range satisfies the constraint
+            static_assert(std::is_integral_v<T>, "Constraint range check requires an integer type");
+            if (! (*this)(min) || ! (*this)(max))
+                return false;
+            if (set_) {
+                using U = std::make_unsigned_t<T>;
+                if (U(U(max) - U(min)) >= set_->size())
+                    return false;
+                for (T t = min; t != max; ++t)
+                    if (set_->count(t) == 0)
+                        return false;
+            }
+            return true;
+        }
+
+        template <typename T>
+        std::string Constraint<T>::str() const {
+            using namespace RS::Format;
+            std::string text;
+            if (min_ && max_)
+                text = format_value(*min_) + " to " + format_value(*max_);
+            else if (min_)
+                text = "at least " + format_value(*min_);
+            else if (max_)
+                text = "at most " + format_value(*max_);
+            else if (set_)
+                text = "one of " + join(values(), ", ");
+            else if (min_length_ > 0 && max_length_ != std::string::npos)
+                text = "length " + std::to_string(min_length_) + " to " + std::to_string(max_length_);
+            else if (min_length_ > 0)
+                text = "length at least " + std::to_string(min_length_);
+            else if (max_length_ != std::string::npos)
+                text = "length at most " + std::to_string(max_length_);
+            return text;
+        }
+
+        template <typename T>
+        std::vector<std::string> Constraint<T>::values() const {
+            std::vector<std::string> names;
+            for (auto& t: list_)
+                names.push_back(RS::Format::format_object(t));
+            return names;
+        }
+
+        template <typename T>
+        Constraint<T> Constraint<T>::limits(std::optional<T> min, std::optional<T> max) {
+            static_assert(Detail::HasLessThan<T>::value, "Constraint range requires an ordered type");
+            Constraint c;
+            c.min_ = min;
+            c.max_ = max;
+            return c;
+        }
+
+        template <typename T>
+        std::string Constraint<T>::format_value(const T& t) {
+            auto str = RS::Format::format_object(t);
+            if constexpr (Detail::is_string_type<T>)
+                str = RS::Format::quote(str);
+            return str;
+        }
+
+    // A sequence of strings that stores each distinct value only once. This
+    // can be used as the target of a multi-valued string option, so memory
+    // scales with the number of distinct arguments rather than their count.
+
+    class InternedStrings {
+
+    public:
+
+        using id_type = uint32_t;
+        using value_type = std::string;
+        using size_type = size_t;
+
+        class const_iterator {
+        public:
+            using difference_type = ptrdiff_t;
+            using iterator_category = std::bidirectional_iterator_tag;
+            using pointer = const std::string*;
+            using reference = const std::string&;
+            using value_type = std::string;
+            const_iterator() = default;
+            const std::string& operator*() const noexcept { return (*owner_)[index_]; }
+            const std::string* operator->() const noexcept { return &**this; }
+            const_iterator& operator++() noexcept { ++index_; return *this; }
+            const_iterator operator++(int) noexcept { auto i = *this; ++*this; return i; }
+            const_iterator& operator--() noexcept { --index_; return *this; }
+            const_iterator operator--(int) noexcept { auto i = *this; --*this; return i; }
+            bool operator==(const const_iterator& i) const noexcept { return index_ == i.index_; }
+            bool operator!=(const const_iterator& i) const noexcept { return index_ != i.index_; }
+        private:
+            friend class InternedStrings;
+            const InternedStrings* owner_ = nullptr;
+            size_t index_ = 0;
+            const_iterator(const InternedStrings* owner, size_t index) noexcept: owner_(owner), index_(index) {}
+        };
+
+        using iterator = const_iterator;
+
+        InternedStrings() = default;
+        InternedStrings(const InternedStrings& s);
+        InternedStrings(InternedStrings&& s) = default;
+        ~InternedStrings() = default;
+        InternedStrings& operator=(const InternedStrings& s);
+        InternedStrings& operator=(InternedStrings&& s) = default;
+
+        const std::string& operator[](size_t i) const noexcept { return symbols_[ids_[i]]; }
+        const_iterator begin() const noexcept { return {this, 0}; }
+        const_iterator end() const noexcept { return {this, ids_.size()}; }
+        void clear() noexcept;
+        size_t distinct() const noexcept { return symbols_.size(); }
+        bool empty() const noexcept { return ids_.empty(); }
+        std::optional<id_type> find(const std::string& str) const;
+        id_type id(size_t i) const noexcept { return ids_[i]; }
+        const std::vector<id_type>& ids() const noexcept { return ids_; }
+        iterator insert(const_iterator pos, const std::string& str);
+        id_type intern(const std::string& str);
+        void push_back(const std::string& str) { ids_.push_back(intern(str)); }
+        size_t size() const noexcept { return ids_.size(); }
+        const std::string& symbol(id_type id) const noexcept { return symbols_[id]; }
+
+    private:
+
+        // The deque keeps strings in place as it grows, so the index can
+        // refer to them by view
+
+        std::deque<std::string> symbols_;
+        std::unordered_map<std::string_view, id_type> index_;
+        std::vector<id_type> ids_;
+
+        void reindex();
+
+    };
+
+    // An option value that is converted from the argument only when first
+    // accessed. Parsing only checks the argument's syntax, and keeps a view
+    // of it. Conversion is not synchronised, so the first access must not
+    // race with another.
+
+    template <typename T>
+    class Lazy {
+
+    public:
+
+        static_assert(! std::is_same_v<T, bool>, "Boolean options can't be lazy");
+        static_assert(! Detail::HasBackInserter<T>::value || Detail::is_string_type<T>,
+            "Lazy options can't have container types, e.g. std::vector");
+        static_assert(! Detail::IsRangeSet<T>::value, "Lazy options can't have range set types");
+
+        using value_type = T;
+
+        Lazy() = default;
+        explicit Lazy(const T& t): value_(t) {}
+
+        const T& operator*() const { return get(); }
+        const T* operator->() const { return &get(); }
+        const T& get() const;
+        bool has_token() const noexcept { return convert_ != nullptr; }
+        std::string_view token() const noexcept { return token_; }
+
+    private:
+
+        friend class Options;
+
+        using converter = std::optional<T> (*)(const std::string&);
+
+        std::string_view token_;
+        converter convert_ = nullptr;
+        mutable std::optional<T> value_;
+
+        void assign(std::string_view token, converter convert) noexcept;
+
+    };
+
+        template <typename T>
+        const T& Lazy<T>::get() const {
+            // A view needs no conversion, and must refer to the argument
+            // itself rather than to a temporary copy of it
+            if constexpr (std::is_same_v<T, std::string_view>)
+                if (convert_ != nullptr && ! value_)
+                    value_ = token_;
+            if (convert_ != nullptr && ! value_) {
+                value_ = convert_(std::string(token_));
+                if (! value_)
+                    throw std::invalid_argument("Invalid argument: " + RS::Format::quote(std::string(token_)));
+            } else if (! value_) {
+                value_.emplace();
+            }
+            return *value_;
+        }
+
+        template <typename T>
+        void Lazy<T>::assign(std::string_view token, converter convert) noexcept {
+            token_ = token;
+            convert_ = convert;
+            value_.reset();
+        }
+
+    // A set of integers stored as sorted, disjoint, non-adjacent closed
+    // intervals. The text form is a comma delimited list of values or
+    // ranges, e.g. "0-4095,8192-16383".
+
+    template <typename T>
+    class RangeSet {
+
+    public:
+
+        static_assert(std::is_integral_v<T> && ! std::is_same_v<T, bool>, "Range set requires an integer type");
+
+        using interval = std::pair<T, T>;
+        using value_type = T;
+
+        class const_iterator {
+        public:
+            using difference_type = ptrdiff_t;
+            using iterator_category = std::forward_iterator_tag;
+            using pointer = const T*;
+            using reference = const T&;
+            using value_type = T;
+            const_iterator() = default;
+            const T& operator*() const noexcept { return value_; }
+            const T* operator->() const noexcept { return &value_; }
+            const_iterator& operator++() noexcept;
+            const_iterator operator++(int) noexcept { auto i = *this; ++*this; return i; }
+            bool operator==(const const_iterator& i) const noexcept { return range_ == i.range_ && value_ == i.value_; }
+            bool operator!=(const const_iterator& i) const noexcept { return ! (*this == i); }
+        private:
+            friend class RangeSet;
+            const interval* range_ = nullptr;
+            const interval* end_ = nullptr;
+            T value_ = 0;
+            const_iterator(const interval* range, const interval* end) noexcept:
+                range_(range), end_(end), value_(range == end ? T(0) : range->first) {}
+        };
+
+        using iterator = const_iterator;
+
+        RangeSet() = default;
+        RangeSet(std::initializer_list<interval> list) { for (auto& [min, max]: list) insert(min, max); }
+
+        const_iterator begin() const noexcept { return {intervals_.data(), intervals_.data() + intervals_.size()}; }
+        const_iterator end() const noexcept { return {intervals_.data() + intervals_.size(), intervals_.data() + intervals_.size()}; }
+        void clear() noexcept { intervals_.clear(); }
+        bool contains(T t) const noexcept;
+        bool empty() const noexcept { return intervals_.empty(); }
+        void insert(T t) { insert(t, t); }
+        void insert(T min, T max);
+        void insert(const RangeSet& set) { for (auto& [min, max]: set.intervals_) insert(min, max); }
+        const std::vector<interval>& intervals() const noexcept { return intervals_; }
+        std::string str() const;
+
+        static std::optional<RangeSet> parse(const std::string& str);
+
+        friend bool operator==(const RangeSet& a, const RangeSet& b) noexcept { return a.intervals_ == b.intervals_; }
+        friend bool operator!=(const RangeSet& a, const RangeSet& b) noexcept { return ! (a == b); }
+
+    private:
+
+        std::vector<interval> intervals_;
+
+    };
+
+        template <typename T>
+        typename RangeSet<T>::const_iterator& RangeSet<T>::const_iterator::operator++() noexcept {
+            if (value_ == range_->second) {
+                ++range_;
+                value_ = range_ == end_ ? T(0) : range_->first;
+            } else {
+                ++value_;
+            }
+            return *this;
+        }
+
+        template <typename T>
+        bool RangeSet<T>::contains(T t) const noexcept {
+            auto it = std::upper_bound(intervals_.begin(), intervals_.end(), t,
+                [] (T x, const interval& r) { return x < r.first; });
+            return it != intervals_.begin() && t <= std::prev(it)->second;
+        }
+
+        template <typename T>
+        void RangeSet<T>::insert(T min, T max) {
+
+            if (max < min)
+                return;
+
+            // Merge with every interval that overlaps or touches the new one
+
+            auto first = std::lower_bound(intervals_.begin(), intervals_.end(), min,
+                [] (const interval& r, T t) { return r.second < t && T(r.second + 1) < t; });
+            auto last = first;
+
+            for (; last != intervals_.end() && (last->first <= max || T(last->first - 1) == max); ++last) {
+                min = std::min(min, last->first);
+                max = std::max(max, last->second);
+            }
+
+            first = intervals_.erase(first, last);
+            intervals_.insert(first, {min, max});
+
+        }
+
+        template <typename T>
+        std::string RangeSet<T>::str() const {
+            std::string text;
+            for (auto& [min, max]: intervals_) {
+                if (! text.empty())
+                    text += ',';
+                text += std::to_string(min);
+                if (max != min)
+                    text += '-' + std::to_string(max);
+            }
+            return text;
+        }
+
+        template <typename T>
+        std::optional<RangeSet<T>> RangeSet<T>::parse(const std::string& str) {
+
+            RangeSet set;
+            auto ptr = str.data();
+            auto end = ptr + str.size();
+
+            for (;;) {
+                T min = 0;
+                auto rc = std::from_chars(ptr, end, min);
+                if (rc.ec != std::errc())
+                    return {};
+                ptr = rc.ptr;
+                T max = min;
+                if (ptr != end && *ptr == '-') {
+                    rc = std::from_chars(ptr + 1, end, max);
+                    if (rc.ec != std::errc() || max < min)
+                        return {};
+                    ptr = rc.ptr;
+                }
+                set.insert(min, max);
+                if (ptr == end)
+                    return set;
+                if (*ptr != ',')
+                    return {};
+                ++ptr;
+            }
+
+        }
 
     class Options {
 
@@ -68,6 +630,186 @@ namespace RS::Option {
             anon        = 1,  // Arguments not claimed by other options are assigned to this
             no_default  = 2,  // Don't show default value in help
             required    = 4,  // Required option
+            parallel    = 8,  // Convert arguments to a multi-valued option in parallel
+            utf8        = 16, // Reject arguments that are not valid UTF-8
+        };
+
+        enum class shell_type: int {
+            bash,
+            fish,
+            zsh,
+        };
+
+        enum class error_code: int {
+            none,
+            ambiguous_option,     // Abbreviated long option matches more than one option
+            constraint_failed,    // Argument does not satisfy the option's constraint
+            invalid_argument,     // Argument could not be converted to the option's type
+            invalid_encoding,     // Argument is not valid UTF-8
+            invalid_option,       // Malformed option name
+            mutually_exclusive,   // More than one option from a mutual exclusion group
+            pattern_mismatch,     // Argument does not match the option's pattern
+            repeated_option,      // Single valued option supplied more than once
+            required_missing,     // Required option not supplied
+            unassigned_argument,  // Argument not claimed by any option
+            unknown_option,       // Option name not recognised
+        };
+
+        static constexpr const char* complete_option = "--_complete";
+        static constexpr size_t stream_buffer_size = 65536;
+
+        using value_callback = std::function<void(std::string_view)>;
+
+        struct parse_error {
+            error_code code = error_code::none;
+            size_t index = std::string::npos;  // Index into the argument list
+            std::string option;                // Option name, if known
+            std::string argument;              // Offending argument, if any
+            explicit operator bool() const noexcept { return code != error_code::none; }
+        };
+
+        class parse_status {
+        public:
+            parse_status(bool proceed) noexcept: proceed_(proceed) {}
+            parse_status(const parse_error& error): error_(error) {}
+            bool has_value() const noexcept { return ! error_; }
+            bool value() const noexcept { return proceed_ && ! error_; }
+            const parse_error& error() const noexcept { return error_; }
+            explicit operator bool() const noexcept { return has_value(); }
+            bool operator*() const noexcept { return value(); }
+        private:
+            parse_error error_;
+            bool proceed_ = false;
+        };
+
+        // Results of the last parse, for every option, independent of any
+        // bound variables. All arguments are held in one buffer, grouped by
+        // option, with per-option ranges into the offset table.
+
+        class parse_result {
+        public:
+            size_t size() const noexcept { return found_.size(); }
+            size_t index(const std::string& name) const;
+            std::string_view name(size_t i) const noexcept;
+            bool found(size_t i) const noexcept { return found_[i] != 0; }
+            bool found(const std::string& name) const;
+            size_t count(size_t i) const noexcept { return counts_[i]; }
+            size_t count(const std::string& name) const;
+            size_t values(size_t i) const noexcept { return first_token_[i + 1] - first_token_[i]; }
+            size_t values(const std::string& name) const;
+            size_t dropped(size_t i) const noexcept { return dropped_.empty() ? 0 : dropped_[i]; }
+            size_t dropped(const std::string& name) const;
+            std::string_view value(size_t i, size_t j = 0) const noexcept;
+            std::string_view value(const std::string& name, size_t j = 0) const;
+            template <typename T> std::optional<T> get(size_t i, size_t j = 0) const;
+            template <typename T> std::optional<T> get(const std::string& name, size_t j = 0) const;
+            size_t frozen_size() const noexcept;
+            void freeze(void* dest) const noexcept;
+        private:
+            friend class Options;
+            std::string names_;                  // All option names
+            std::vector<size_t> name_offsets_;   // Size is options + 1
+            std::vector<uint32_t> sorted_;       // Option indices in name order
+            std::vector<uint8_t> found_;
+            std::vector<uint32_t> counts_;       // Occurrences of the option
+            std::vector<size_t> first_token_;    // Size is options + 1
+            std::string tokens_;                 // All arguments, grouped by option
+            std::vector<size_t> token_offsets_;  // Size is arguments + 1
+            std::vector<size_t> dropped_;        // Values not kept by bounded options, empty if none
+        };
+
+        // A parse result frozen into one flat block of memory, e.g. a shared
+        // mapping inherited by forked workers. The block holds only 64-bit
+        // integers (offsets, never pointers) followed by the text, so it is
+        // read in place at any address.
+
+        class frozen_result {
+        public:
+            frozen_result() = default;
+            frozen_result(const void* data, size_t bytes);
+            size_t size() const noexcept { return size_; }
+            size_t index(const std::string& name) const;
+            std::string_view name(size_t i) const noexcept;
+            bool found(size_t i) const noexcept { return count(i) != 0; }
+            bool found(const std::string& name) const;
+            size_t count(size_t i) const noexcept { return size_t(counts_[i]); }
+            size_t count(const std::string& name) const;
+            size_t values(size_t i) const noexcept { return size_t(first_token_[i + 1] - first_token_[i]); }
+            size_t values(const std::string& name) const;
+            std::string_view value(size_t i, size_t j = 0) const noexcept;
+            std::string_view value(const std::string& name, size_t j = 0) const;
+            template <typename T> std::optional<T> get(size_t i, size_t j = 0) const;
+            template <typename T> std::optional<T> get(const std::string& name, size_t j = 0) const;
+        private:
+            size_t size_ = 0;
+            const uint64_t* name_offsets_ = nullptr;
+            const uint64_t* sorted_ = nullptr;
+            const uint64_t* counts_ = nullptr;
+            const uint64_t* first_token_ = nullptr;
+            const uint64_t* token_offsets_ = nullptr;
+            const char* names_ = nullptr;
+            const char* tokens_ = nullptr;
+        };
+
+        // Option occurrences in command line order, read lazily from the
+        // argument list. Events refer to the arguments and option names in
+        // place; the range holds all the tokenizer state, so nothing is
+        // allocated as it advances.
+
+        struct event {
+            size_t option = std::string::npos;  // Option index, as in parse_result, npos if unknown
+            std::string_view name;              // Option name, empty if unknown
+            std::string_view value;             // Argument, "t" or "f" for a boolean option
+            size_t index = std::string::npos;   // Index into the argument list
+            error_code error = error_code::none;
+        };
+
+        class event_range {
+        public:
+            class iterator {
+            public:
+                using difference_type = ptrdiff_t;
+                using iterator_category = std::input_iterator_tag;
+                using pointer = const event*;
+                using reference = const event&;
+                using value_type = event;
+                iterator() = default;
+                const event& operator*() const noexcept { return range_->event_; }
+                const event* operator->() const noexcept { return &range_->event_; }
+                iterator& operator++() { if (! (range_->live_ = range_->advance())) range_ = nullptr; return *this; }
+                void operator++(int) { ++*this; }
+                bool operator==(const iterator& i) const noexcept { return range_ == i.range_; }
+                bool operator!=(const iterator& i) const noexcept { return range_ != i.range_; }
+            private:
+                friend class event_range;
+                event_range* range_ = nullptr;
+                explicit iterator(event_range* range) noexcept: range_(range) {}
+            };
+            iterator begin();
+            iterator end() noexcept { return {}; }
+        private:
+            friend class Options;
+            const Options* owner_ = nullptr;
+            char** argv_ = nullptr;                // Either argv_ or args_ is set
+            const std::string* args_ = nullptr;
+            std::shared_ptr<const std::vector<std::string>> owned_;  // Set if the range owns args_
+            size_t size_ = 0;
+            size_t pos_ = 0;                       // Argument being read
+            size_t short_pos_ = 0;                 // Position within a group of short options
+            size_t current_ = std::string::npos;   // Option receiving arguments
+            size_t current_index_ = 0;             // Where the current option appeared
+            bool waiting_ = false;                 // Current option has no argument yet
+            bool escaped_ = false;
+            bool skipping_ = false;
+            bool started_ = false;
+            bool live_ = false;                    // event_ holds the current event
+            std::vector<uint8_t> found_;
+            event event_;
+            event_range(const Options& owner, char** argv, const std::string* args, size_t size);
+            std::string_view arg(size_t i) const noexcept { return argv_ ? std::string_view(argv_[i]) : args_[i]; }
+            bool advance();
+            bool emit(size_t option, std::string_view value, size_t index) noexcept;
+            bool fail(error_code code, std::string_view value, size_t index, size_t option = std::string::npos) noexcept;
         };
 
         class setup_error:
@@ -88,54 +830,226 @@ namespace RS::Option {
 
         template <typename T> Options& add(T& var, const std::string& name, char abbrev, const std::string& description,
             int flags = 0, const std::string& group = {}, const std::string& pattern = {});
+        template <typename T, typename U> Options& add(T& var, const std::string& name, char abbrev,
+            const std::string& description, int flags, const std::string& group, const Constraint<U>& constraint);
+        template <typename T> Options& bind(T& var, const std::string& name);
+        template <typename T, typename U> Options& bind(T& var, const std::string& name, const Constraint<U>& constraint);
+        std::string save_spec();
+        static Options load_spec(std::string_view spec);
+        void allow_prefix() noexcept { allow_prefix_ = true; }
         void auto_help() noexcept { auto_help_ = true; }
+        void check_utf8() noexcept { check_utf8_ = true; }
         void set_colour(bool b) noexcept { colour_ = int(b); }
+        void stream_args(const std::string& name, int fd = 0, char delimiter = '\0', value_callback callback = {});
         bool parse(std::vector<std::string> args, std::ostream& out = std::cout);
         bool parse(int argc, char** argv, std::ostream& out = std::cout);
+        parse_status try_parse(std::vector<std::string> args, std::ostream& out = std::cout);
+        parse_status try_parse(int argc, char** argv, std::ostream& out = std::cout);
+        std::vector<parse_error> check(std::vector<std::string> args);
+        std::vector<parse_error> check(int argc, char** argv);
+        std::vector<size_t> reparse(std::vector<std::string> args);
+        event_range events(const std::vector<std::string>& args);
+        event_range events(std::vector<std::string>&& args);
+        event_range events(int argc, char** argv);
+        std::string error_message(const parse_error& error) const;
         bool found(const std::string& name) const;
+        const parse_result& result() const;
+        std::string completion_script(shell_type shell, const std::string& command) const;
 
     private:
 
-        using setter_type = std::function<void(const std::string&)>;
+        using formatter_type = std::function<std::string()>;
+        using setter_type = std::function<error_code(const std::string&, bool)>;  // (argument, commit)
+        using view_setter_type = std::function<error_code(std::string_view, bool)>;  // For string_view targets
         using validator_type = std::function<bool(const std::string&)>;
+        using values_type = std::function<std::vector<std::string>()>;
+        using batch_error = std::pair<size_t, error_code>;  // (position, error)
+        using batch_type = std::function<std::vector<batch_error>(const std::vector<const std::string*>&, bool)>;
+        using reset_type = std::function<void()>;
+
+        // The typed front end reduces each argument type to a few plain
+        // conversion functions; the function wrappers, validators, and
+        // parallel batch machinery around them are shared by all types
+
+        using check_pointer = std::shared_ptr<const void>;  // Type-erased constraint, null if none
+        using convert_function = error_code (*)(void* var, const void* check, const std::string& str, bool commit);
+        using element_function = error_code (*)(void* values, const void* check, size_t index, const std::string& str);
 
-        enum class mode { boolean, single, multiple };
+        enum class mode: uint8_t { boolean, single, multiple };
+        enum class numeric { signed_integer, unsigned_integer, floating };
+
+        // Options are held in three parallel arrays: the fields used in the
+        // parse loop, references to text in a shared arena, and the
+        // type-specific functions
 
         struct option_info {
-            setter_type setter;
-            validator_type validator;
-            std::string name;
-            std::string description;
-            std::string placeholder;
-            std::string default_value;
-            std::string group;
+            uint32_t hash = 0;   // Hash of the name, compared before the text
+            uint16_t group = 0;  // Index into groups_ plus one, zero if none
             char abbrev = '\0';
             mode kind = mode::single;
             bool is_anon = false;
             bool is_no_default = false;
+            bool is_parallel = false;
             bool is_required = false;
+            bool is_utf8 = false;
+            bool is_unbound = false;  // Loaded from a spec, waiting for bind()
             bool found = false;
         };
 
+        struct text_ref {
+            uint32_t offset = 0;
+            uint32_t size = 0;
+        };
+
+        struct option_text {
+            text_ref name;
+            text_ref description;
+            text_ref placeholder;
+            text_ref pattern;
+        };
+
+        struct option_calls {
+            setter_type setter;
+            view_setter_type view_setter;  // Used instead of setter if present
+            validator_type validator;
+            values_type values;            // List of valid arguments, if known
+            formatter_type default_value;  // Only called when help is printed
+            formatter_type constraint;     // Description of any constraint
+            batch_type batch;              // Deferred conversion of all arguments (parallel flag)
+            reset_type reset;              // Restores the variable's original value
+            // Copies of the arguments a view_setter target refers to, replaced
+            // when a single valued option is set again
+            mutable std::shared_ptr<std::deque<std::string>> view_store;
+            size_t bound = std::string::npos;  // Values kept in the result (Bounded targets)
+            bool keep_first = false;
+        };
+
+        // Raw tokens from the command line, collected without checking or
+        // converting any arguments
+
+        struct token_scan {
+            std::vector<uint8_t> found;
+            std::vector<uint32_t> counts;
+            std::vector<std::pair<uint32_t, std::string_view>> tokens;  // (option, argument)
+            std::vector<size_t> indices;                                // Argument index of each token
+        };
+
+        // Extra arguments read from a file descriptor after the command line
+
+        struct stream_source {
+            size_t option = std::string::npos;
+            int fd = -1;
+            char delimiter = '\0';
+            value_callback callback;  // Receives each value instead of the option's variable
+        };
+
+        // Index of long option names, including the --no-xxx forms of
+        // boolean options. Entries are sorted by key, and each trie node
+        // covers the contiguous range of entries that share its prefix.
+
+        class name_index {
+        public:
+            friend class Options;
+            struct entry {
+                std::string key;
+                size_t option;
+                bool invert;
+            };
+            void build(const Options& options);
+            std::pair<const entry*, const entry*> find(std::string_view key, bool prefix) const;
+            std::pair<const entry*, const entry*> complete(std::string_view prefix) const;
+            std::string closest(const std::string& key) const;
+        private:
+            struct node {
+                uint32_t first;         // Entries in subtree
+                uint32_t last;
+                uint32_t child_begin;   // Children in nodes_
+                uint32_t child_end;
+                char label;
+            };
+            std::vector<entry> entries_;
+            std::vector<node> nodes_;
+        };
+
         std::vector<option_info> options_;
+        std::vector<option_text> texts_;
+        std::vector<option_calls> calls_;
+        std::vector<text_ref> groups_;
+        std::string arena_;  // Text for all options
+        std::unordered_map<std::string, text_ref> placeholders_;  // Shared placeholder text, only kept during setup
+        name_index index_;
+        mutable parse_result result_;
+        mutable std::vector<std::string> result_args_;  // Arguments of the last parse, until the result is built
+        stream_source stream_;
         std::string app_;
         std::string version_;
         std::string description_;
         std::string extra_;
         int colour_ = 0;
         bool allow_help_ = false;
+        bool allow_prefix_ = false;
         bool auto_help_ = false;
+        bool check_utf8_ = false;
+        bool index_stale_ = false;  // Options were added after the index was built
+        mutable bool result_pending_ = false;
 
-        void do_add(setter_type setter, validator_type validator, const std::string& name, char abbrev,
-            const std::string& description, const std::string& placeholder, const std::string& default_value,
-            mode kind, int flags, const std::string& group);
+        void add_standard();
+        bool fast_exit(std::string_view arg, std::ostream& out);
+        parse_status do_parse(std::vector<std::string> args, const std::vector<std::string_view>& views,
+            std::ostream& out);
+        std::vector<uint8_t> parse_args(const std::vector<std::string>& args,
+            const std::vector<std::string_view>& views, bool dry_run, std::vector<parse_error>& errors,
+            token_scan* scan = nullptr) const;
+        void read_stream(size_t first_index, std::vector<parse_error>& errors);
+        error_code set_view(size_t i, std::string_view value) const;
+        void set_result(const std::vector<uint8_t>& found, const std::vector<uint32_t>& counts,
+            const std::vector<std::pair<uint32_t, std::string_view>>& tokens) const;
+        std::string complete(const std::vector<std::string>& words) const;
+        std::string bash_script(const std::string& command) const;
+        std::string fish_script(const std::string& command) const;
+        std::string zsh_script(const std::string& command) const;
+        size_t do_add(option_calls calls, const std::string& name, char abbrev, const std::string& description,
+            const std::string& placeholder, const std::string& pattern, mode kind, int flags, const std::string& group);
+        size_t unbound_option(const std::string& name) const;
+        int option_flags(size_t i) const noexcept;
+        std::string_view text(text_ref ref) const noexcept { return std::string_view(arena_).substr(ref.offset, ref.size); }
+        std::string name_of(size_t i) const { return std::string(text(texts_[i].name)); }
+        std::string group_of(size_t i) const;
+        text_ref add_text(std::string_view str, bool intern = false);
+        uint16_t add_group(const std::string& group);
         std::string format_help() const;
-        std::string group_list(const std::string& group) const;
+        std::string group_list(uint16_t group) const;
         size_t option_index(const std::string& name) const;
         size_t option_index(char abbrev) const;
 
-        template <typename T> static T parse_argument(const std::string& arg);
-        template <typename T> static validator_type type_validator(const std::string& name, std::string pattern);
+        struct no_constraint {
+            template <typename... U> bool operator()(const U&...) const noexcept { return true; }
+        };
+
+        template <typename T, typename Check> Options& add_option(T& var, const std::string& name, char abbrev,
+            const std::string& description, int flags, const std::string& group, const std::string& pattern,
+            const Check& check, values_type values, formatter_type constraint);
+        static setter_type make_setter(void* var, check_pointer check, convert_function convert);
+        static std::vector<batch_error> run_batch(const std::vector<const std::string*>& args, bool dry_run,
+            const validator_type& validator, const void* check, void* values, element_function convert);
+        static validator_type numeric_validator(numeric type);
+        static validator_type name_validator(const std::vector<std::string>& names);
+        validator_type pattern_validator(const std::string& name, const std::string& pattern, bool is_string) const;
+        static values_type name_values(const std::vector<std::string>& names);
+        static bool match_numeric(numeric type, const std::string& str);
+        static void run_parallel(size_t n, const std::function<void(size_t, size_t)>& fn);
+        static bool parse_boolean(const std::string& arg, bool& b) noexcept;
+        template <typename Check> static check_pointer share_check(const Check& check);
+        template <typename T, typename Check> static error_code convert_value(void* var, const void* check,
+            const std::string& str, bool commit);
+        template <typename T, typename Check> static error_code insert_value(void* var, const void* check,
+            const std::string& str, bool commit);
+        template <typename T, typename Check> static error_code convert_element(void* values, const void* check,
+            size_t index, const std::string& str);
+        template <typename T> static std::optional<T> parse_argument(const std::string& arg);
+        template <typename T> static bool parse_number(const std::string& arg, T& t) noexcept;
+        template <typename T> validator_type type_validator(const std::string& name, std::string pattern) const;
+        template <typename T> static values_type type_values();
         template <typename T> static std::string type_placeholder();
 
     };
@@ -143,6 +1057,45 @@ namespace RS::Option {
         template <typename T>
         Options& Options::add(T& var, const std::string& name, char abbrev, const std::string& description,
                 int flags, const std::string& group, const std::string& pattern) {
+            return add_option(var, name, abbrev, description, flags, group, pattern, no_constraint(), {}, {});
+        }
+
+        template <typename T, typename U>
+        Options& Options::add(T& var, const std::string& name, char abbrev, const std::string& description,
+                int flags, const std::string& group, const Constraint<U>& constraint) {
+            using namespace Detail;
+            static_assert(std::is_same_v<T, U> || std::is_same_v<typename ValueType<T>::type, U>,
+                "Constraint type does not match argument type");
+            static_assert(! std::is_same_v<U, bool>, "Boolean options can't have constraints");
+            static_assert(! IsLazy<T>::value, "Lazy options can't have constraints");
+            values_type values;
+            if (! constraint.values().empty())
+                values = [constraint] { return constraint.values(); };
+            return add_option(var, name, abbrev, description, flags, group, {}, constraint,
+                values, [constraint] { return constraint.str(); });
+        }
+
+        template <typename T>
+        Options& Options::bind(T& var, const std::string& name) {
+            auto i = unbound_option(name);
+            return add_option(var, name_of(i), options_[i].abbrev, std::string(text(texts_[i].description)),
+                option_flags(i), group_of(i), std::string(text(texts_[i].pattern)), no_constraint(), {}, {});
+        }
+
+        template <typename T, typename U>
+        Options& Options::bind(T& var, const std::string& name, const Constraint<U>& constraint) {
+            using namespace Detail;
+            static_assert(std::is_same_v<T, U> || std::is_same_v<typename ValueType<T>::type, U>,
+                "Constraint type does not match argument type");
+            auto i = unbound_option(name);
+            return add_option(var, name_of(i), options_[i].abbrev, std::string(text(texts_[i].description)),
+                option_flags(i), group_of(i), {}, constraint, {}, {});
+        }
+
+        template <typename T, typename Check>
+        Options& Options::add_option(T& var, const std::string& name, char abbrev, const std::string& description,
+                int flags, const std::string& group, const std::string& pattern, const Check& check,
+                values_type values, formatter_type constraint) {
 
             using namespace Detail;
             using namespace RS::Format;
@@ -150,33 +1103,111 @@ namespace RS::Option {
 
             static_assert(is_valid_argument_type<T>, "Invalid command line argument type");
 
-            setter_type setter;
-            validator_type validator;
+            option_calls calls;
             std::string placeholder;
-            std::string default_value;
             mode kind;
 
+            calls.values = values;
+            calls.constraint = constraint;
+            calls.reset = [&var,initial = var] { var = initial; };
+
             if constexpr (std::is_same_v<T, bool>) {
 
-                setter = [&var] (const std::string& str) { var = to_boolean(str); };
+                calls.setter = [&var] (const std::string& str, bool commit) {
+                    bool value = false;
+                    if (! parse_boolean(str, value))
+                        return error_code::invalid_argument;
+                    if (commit)
+                        var = value;
+                    return error_code::none;
+                };
                 kind = mode::boolean;
 
+            } else if constexpr (IsRangeSet<T>::value) {
+
+                // Each argument is a list of ranges, merged into the set
+
+                if (! var.empty())
+                    throw setup_error("Multi-valued options may not have default values: --" + name);
+                if ((flags & parallel) != 0)
+                    throw setup_error("Parallel conversion is not supported for range sets: --" + name);
+
+                calls.setter = [&var,check] (const std::string& str, bool commit) {
+                    auto value = T::parse(str);
+                    if (! value)
+                        return error_code::invalid_argument;
+                    for (auto& [min, max]: value->intervals())
+                        if (! check(min, max))
+                            return error_code::constraint_failed;
+                    if (commit)
+                        var.insert(*value);
+                    return error_code::none;
+                };
+                placeholder = "<ranges>";
+                kind = mode::multiple;
+
+            } else if constexpr (IsLazy<T>::value) {
+
+                // Only the syntax is checked here; conversion happens on access
+
+                using VT = typename T::value_type;
+
+                calls.view_setter = [&var] (std::string_view str, bool commit) {
+                    if (commit)
+                        var.assign(str, &Options::parse_argument<VT>);
+                    return error_code::none;
+                };
+                calls.validator = type_validator<VT>(name, pattern);
+                if (! calls.values)
+                    calls.values = type_values<VT>();
+                placeholder = type_placeholder<VT>();
+                kind = mode::single;
+
+                if ((flags & (required | no_default)) == 0 && var.value_ && (std::is_enum_v<VT> || *var.value_ != VT())) {
+                    calls.default_value = [value = *var.value_] {
+                        auto str = format_object(value);
+                        if constexpr (! std::is_arithmetic_v<VT> && ! std::is_enum_v<VT>)
+                            if (! str.empty())
+                                str = quote(str);
+                        return str;
+                    };
+                }
+
             } else if constexpr (is_scalar_argument_type<T>) {
 
-                setter = [&var] (const std::string& str) { var = parse_argument<T>(str); };
-                validator = type_validator<T>(name, pattern);
+                if constexpr (std::is_same_v<T, std::string_view>)
+                    calls.view_setter = [&var,check] (std::string_view str, bool commit) {
+                        if (! check(str))
+                            return error_code::constraint_failed;
+                        if (commit)
+                            var = str;
+                        return error_code::none;
+                    };
+                else
+                    calls.setter = make_setter(&var, share_check(check), &convert_value<T, Check>);
+                calls.validator = type_validator<T>(name, pattern);
+                if (! calls.values)
+                    calls.values = type_values<T>();
                 placeholder = type_placeholder<T>();
                 kind = mode::single;
 
-                if constexpr (std::is_same_v<T, std::string>)
-                    if (validator && ! validator(var))
+                if constexpr (is_string_type<T>)
+                    if (calls.validator && ! calls.validator(std::string(var)))
                         throw setup_error("Default value does not match pattern: --" + name);
 
-                if ((flags & required) == 0 && (std::is_enum_v<T> || var != T())) {
-                    default_value = format_object(var);
-                    if constexpr (! std::is_arithmetic_v<T> && ! std::is_enum_v<T>)
-                        if (! default_value.empty())
-                            default_value = quote(default_value);
+                if ((flags & required) == 0 && var != T() && ! check(var))
+                    throw setup_error("Default value does not satisfy constraint: --" + name);
+
+                // Formatting is deferred until the help text is actually needed
+
+                if ((flags & (required | no_default)) == 0 && (std::is_enum_v<T> || var != T())) {
+                    calls.default_value = [value = var] {
+                        auto str = format_object(value);
+                        if constexpr (! std::is_arithmetic_v<T> && ! std::is_enum_v<T>)
+                            if (! str.empty())
+                                str = quote(str);
+                        return str;
+                    };
                 }
 
             } else {
@@ -186,83 +1217,218 @@ namespace RS::Option {
                 if (! var.empty())
                     throw setup_error("Multi-valued options may not have default values: --" + name);
 
-                setter = [&var] (const std::string& str) { var.insert(var.end(), parse_argument<VT>(str)); };
-                validator = type_validator<VT>(name, pattern);
+                if constexpr (std::is_same_v<VT, std::string_view>)
+                    calls.view_setter = [&var,check] (std::string_view str, bool commit) {
+                        if (! check(str))
+                            return error_code::constraint_failed;
+                        if (commit)
+                            var.insert(var.end(), str);
+                        return error_code::none;
+                    };
+                else
+                    calls.setter = make_setter(&var, share_check(check), &insert_value<T, Check>);
+                calls.validator = type_validator<VT>(name, pattern);
+                if (! calls.values)
+                    calls.values = type_values<VT>();
                 placeholder = type_placeholder<VT>();
                 kind = mode::multiple;
 
+                if constexpr (IsBounded<T>::value) {
+                    calls.bound = var.capacity();
+                    calls.keep_first = var.keep() == T::first;
+                }
+
+            }
+
+            if constexpr (is_container_argument_type<T>) {
+
+                // Arguments are converted in parallel by run_batch(), then
+                // inserted in their original order
+
+                // String views need no conversion, so they are always set directly
+
+                using VT = typename T::value_type;
+
+                if ((flags & parallel) != 0 && ! std::is_same_v<VT, std::string_view>) {
+                    calls.batch = [&var,shared = share_check(check),validator = calls.validator]
+                            (const std::vector<const std::string*>& args, bool dry_run) {
+                        std::vector<std::optional<VT>> values(args.size());
+                        auto errors = run_batch(args, dry_run, validator, shared.get(), &values, &convert_element<VT, Check>);
+                        if (errors.empty() && ! dry_run)
+                            for (auto& value: values)
+                                var.insert(var.end(), std::move(*value));
+                        return errors;
+                    };
+                }
+
             }
 
-            do_add(setter, validator, name, abbrev, description, placeholder, default_value, kind, flags, group);
+            do_add(std::move(calls), name, abbrev, description, placeholder, pattern, kind, flags, group);
 
             return *this;
 
         }
 
         template <typename T>
-        T Options::parse_argument(const std::string& arg) {
+        std::optional<T> Options::parse_result::get(size_t i, size_t j) const {
+            static_assert(Detail::is_scalar_argument_type<T> && ! std::is_same_v<T, std::string_view>,
+                "Invalid result type");
+            if (i >= size() || j >= values(i))
+                return {};
+            return parse_argument<T>(std::string(value(i, j)));
+        }
+
+        template <typename T>
+        std::optional<T> Options::parse_result::get(const std::string& name, size_t j) const {
+            return get<T>(index(name), j);
+        }
+
+        template <typename T>
+        std::optional<T> Options::frozen_result::get(size_t i, size_t j) const {
+            static_assert(Detail::is_scalar_argument_type<T> && ! std::is_same_v<T, std::string_view>,
+                "Invalid result type");
+            if (i >= size() || j >= values(i))
+                return {};
+            return parse_argument<T>(std::string(value(i, j)));
+        }
+
+        template <typename T>
+        std::optional<T> Options::frozen_result::get(const std::string& name, size_t j) const {
+            return get<T>(index(name), j);
+        }
+
+        template <typename Check>
+        Options::check_pointer Options::share_check(const Check& check) {
+            if constexpr (std::is_same_v<Check, no_constraint>)
+                return {};
+            else
+                return std::make_shared<const Check>(check);
+        }
+
+        template <typename T, typename Check>
+        Options::error_code Options::convert_value(void* var, const void* check, const std::string& str, bool commit) {
+            auto value = parse_argument<T>(str);
+            if (! value)
+                return error_code::invalid_argument;
+            if (check != nullptr && ! (*static_cast<const Check*>(check))(*value))
+                return error_code::constraint_failed;
+            if (commit)
+                *static_cast<T*>(var) = std::move(*value);
+            return error_code::none;
+        }
+
+        template <typename T, typename Check>
+        Options::error_code Options::insert_value(void* var, const void* check, const std::string& str, bool commit) {
+            using VT = typename T::value_type;
+            auto value = parse_argument<VT>(str);
+            if (! value)
+                return error_code::invalid_argument;
+            if (check != nullptr && ! (*static_cast<const Check*>(check))(*value))
+                return error_code::constraint_failed;
+            if (commit) {
+                auto& container = *static_cast<T*>(var);
+                container.insert(container.end(), std::move(*value));
+            }
+            return error_code::none;
+        }
+
+        template <typename T, typename Check>
+        Options::error_code Options::convert_element(void* values, const void* check, size_t index, const std::string& str) {
+            auto& value = (*static_cast<std::vector<std::optional<T>>*>(values))[index];
+            if (! (value = parse_argument<T>(str)))
+                return error_code::invalid_argument;
+            if (check != nullptr && ! (*static_cast<const Check*>(check))(*value))
+                return error_code::constraint_failed;
+            return error_code::none;
+        }
+
+        template <typename T>
+        std::optional<T> Options::parse_argument(const std::string& arg) {
             using namespace Detail;
-            using namespace RS::Format;
-            using namespace RS::Format::Literals;
             static_assert(is_scalar_argument_type<T>);
-            if constexpr (std::is_enum_v<T>)
-                return parse_enum_unchecked<T>(arg);
-            else if constexpr (std::is_same_v<T, std::string>)
+            if constexpr (HasOptionTraits<T>::value) {
+                T t{};
+                if (OptionTraits<T>::parse(arg, t))
+                    return t;
+            } else if constexpr (std::is_enum_v<T>) {
+                T t = {};
+                if (parse_enum(arg, t))
+                    return t;
+            } else if constexpr (std::is_same_v<T, std::string>) {
                 return arg;
-            else if constexpr (std::is_same_v<T, bool>)
-                return to_boolean(arg);
-            else if constexpr (std::is_integral_v<T>)
-                return to_integer<T>(arg);
-            else if constexpr (std::is_floating_point_v<T>)
-                return to_floating<T>(arg);
-            else if constexpr (std::is_constructible_v<T, int>)
-                return static_cast<T>(to_int64(arg));
-            else
-                return static_cast<T>(arg);
+            } else if constexpr (std::is_same_v<T, bool>) {
+                bool t = false;
+                if (parse_boolean(arg, t))
+                    return t;
+            } else if constexpr (std::is_arithmetic_v<T>) {
+                T t = 0;
+                if (parse_number(arg, t))
+                    return t;
+            } else if constexpr (std::is_constructible_v<T, int>) {
+                int64_t n = 0;
+                if (parse_number(arg, n))
+                    return static_cast<T>(n);
+            } else {
+                // User defined constructors may still throw
+                try {
+                    return static_cast<T>(arg);
+                }
+                catch (const std::invalid_argument&) {}
+            }
+            return {};
         }
 
         template <typename T>
-        Options::validator_type Options::type_validator(const std::string& name, std::string pattern) {
+        bool Options::parse_number(const std::string& arg, T& t) noexcept {
+            // The format has usually already been checked by the validator
+            auto begin = arg.data();
+            auto end = begin + arg.size();
+            if (begin != end && *begin == '+') {
+                ++begin;
+                if (begin != end && *begin == '-')
+                    return false;
+            }
+            auto rc = std::from_chars(begin, end, t);
+            return rc.ec == std::errc() && rc.ptr == end;
+        }
 
-            using namespace RS::Format::Literals;
-            using namespace RS::RE;
+        template <typename T>
+        Options::validator_type Options::type_validator(const std::string& name, std::string pattern) const {
 
-            validator_type validator;
+            // An explicit pattern replaces the type's own validator
 
-            if constexpr (! std::is_same_v<T, std::string>)
-                if (! pattern.empty())
-                    throw setup_error("Pattern is only allowed for string-valued options: {0:q}"_fmt("--" + name));
+            auto validator = pattern_validator(name, pattern, Detail::is_string_type<T>);
 
-            if constexpr (std::is_enum_v<T>)
-                validator = [] (const std::string& str) {
-                    auto& names = list_enum_names(T());
-                    return std::find(names.begin(), names.end(), str) != names.end();
-                };
+            if (validator)
+                return validator;
+            else if constexpr (Detail::HasTraitsValidator<T>::value)
+                return [] (const std::string& str) { return OptionTraits<T>::validate(str); };
+            else if constexpr (std::is_enum_v<T>)
+                return name_validator(list_enum_names(T()));
             else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
-                pattern = R"([+-]?\d+)";
+                return numeric_validator(numeric::signed_integer);
             else if constexpr (std::is_integral_v<T> && std::is_unsigned_v<T>)
-                pattern = R"(\+?\d+)";
+                return numeric_validator(numeric::unsigned_integer);
             else if constexpr (std::is_floating_point_v<T>)
-                pattern = R"([+-]?(\d+(\.\d*)?|\.\d+)([Ee][+-]?\d+)?)";
-
-            if (! pattern.empty()) {
-                Regex re;
-                try {
-                    re = Regex(pattern, Regex::full | Regex::no_capture);
-                }
-                catch (const Regex::error& ex) {
-                    throw setup_error(ex.what());
-                }
-                validator = [re] (const std::string& str) { return re(str).matched(); };
-            }
+                return numeric_validator(numeric::floating);
+            else
+                return {};
 
-            return validator;
+        }
 
+        template <typename T>
+        Options::values_type Options::type_values() {
+            if constexpr (std::is_enum_v<T>)
+                return name_values(list_enum_names(T()));
+            else
+                return {};
         }
 
         template <typename T>
         std::string Options::type_placeholder() {
-            if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+            if constexpr (Detail::HasTraitsPlaceholder<T>::value)
+                return OptionTraits<T>::placeholder;
+            else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
                 return "<int>";
             else if constexpr (std::is_integral_v<T> && std::is_unsigned_v<T>)
                 return "<uint>";
@@ -0,0 +1,128 @@
+#include "rs-options/options.hpp"
+#include "rs-format/format.hpp"
+#include "rs-unit-test.hpp"
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace RS::Format;
+using namespace RS::Option;
+
+void test_rs_options_bounded_class() {
+
+    Bounded<int> b(3);
+
+    TEST(b.empty());
+    TEST_EQUAL(b.capacity(), 3u);
+    TEST_EQUAL(b.keep(), Bounded<int>::last);
+    TEST(b.begin() == b.end());
+
+    for (int i = 1; i <= 2; ++i)
+        TRY(b.push_back(i));
+    TEST_EQUAL(b.size(), 2u);
+    TEST_EQUAL(format_range(b), "[1,2]");
+    TEST_EQUAL(b.dropped(), 0u);
+
+    for (int i = 3; i <= 7; ++i)
+        TRY(b.insert(b.begin(), i));
+    TEST_EQUAL(b.size(), 3u);
+    TEST_EQUAL(format_range(b), "[5,6,7]");
+    TEST_EQUAL(b.front(), 5);
+    TEST_EQUAL(b.back(), 7);
+    TEST_EQUAL(b[1], 6);
+    TEST_EQUAL(b.dropped(), 4u);
+
+    Bounded<int> c(3, Bounded<int>::first);
+
+    for (int i = 1; i <= 7; ++i)
+        TRY(c.push_back(i));
+    TEST_EQUAL(format_range(c), "[1,2,3]");
+    TEST_EQUAL(c.dropped(), 4u);
+    TEST(b != c);
+
+    TRY(b.clear());
+    TEST(b.empty());
+    TEST_EQUAL(b.dropped(), 0u);
+    TEST_EQUAL(b.capacity(), 3u);
+
+    Bounded<int> d;
+    TRY(d.push_back(1));
+    TEST(d.empty());
+    TEST_EQUAL(d.dropped(), 1u);
+
+}
+
+void test_rs_options_bounded_option() {
+
+    Bounded<std::string> hosts(2);
+    Bounded<int> codes(2, Bounded<int>::first);
+    std::vector<std::string> files;
+
+    Options opt("Hello", "1.0", "Says hello.");
+    TRY(opt.set_colour(false));
+    TRY(opt.add(hosts, "host", 'h', "Retry host"));
+    TRY(opt.add(codes, "code", 'c', "Exit code"));
+    TRY(opt.add(files, "file", 'f', "Input file", Options::anon));
+
+    {
+        Bounded<int> full(2);
+        full.push_back(1);
+        Options opt2("Hello", "1.0", "Says hello.");
+        TEST_THROW(opt2.add(full, "full", 'x', "Full"), Options::setup_error);
+    }
+
+    std::vector<std::string> args = {"a.txt"};
+    for (int i = 0; i < 1000; ++i) {
+        args.push_back("--host");
+        args.push_back("h" + std::to_string(i));
+        args.push_back("-c");
+        args.push_back(std::to_string(i));
+    }
+
+    std::ostringstream out;
+    TEST(opt.parse(args, out));
+    TEST_EQUAL(format_range(hosts), "[h998,h999]");
+    TEST_EQUAL(hosts.dropped(), 998u);
+    TEST_EQUAL(format_range(codes), "[0,1]");
+    TEST_EQUAL(codes.dropped(), 998u);
+    TEST_EQUAL(format_range(files), "[a.txt]");
+
+    // The result holds only the values that were kept
+
+    auto& r = opt.result();
+    TEST_EQUAL(r.count("host"), 1000u);
+    TEST_EQUAL(r.values("host"), 2u);
+    TEST_EQUAL(r.dropped("host"), 998u);
+    TEST_EQUAL(r.value("host", 0), "h998");
+    TEST_EQUAL(r.value("host", 1), "h999");
+    TEST_EQUAL(r.values("code"), 2u);
+    TEST_EQUAL(r.value("code", 1), "1");
+    TEST_EQUAL(r.dropped("code"), 998u);
+    TEST_EQUAL(r.values("file"), 1u);
+    TEST_EQUAL(r.dropped("file"), 0u);
+    TEST_EQUAL(r.dropped("nonsense"), 0u);
+
+    TEST_THROW(opt.parse({"-c", "x"}, out), Options::user_error);
+
+    // The bound is taken from the variable when a saved spec is bound
+
+    {
+        std::string spec;
+        {
+            Bounded<std::string> tags(2);
+            Options opt2("Hello", "1.0", "Says hello.");
+            TRY(opt2.add(tags, "tag", 't', "Tag"));
+            TRY(spec = opt2.save_spec());
+        }
+        Bounded<std::string> tags(2);
+        Options opt2;
+        TRY(opt2 = Options::load_spec(spec));
+        TRY(opt2.bind(tags, "tag"));
+        TEST(opt2.parse({"-t", "a", "-t", "b", "-t", "c", "-t", "d"}, out));
+        TEST_EQUAL(format_range(tags), "[c,d]");
+        TEST_EQUAL(tags.dropped(), 2u);
+        TEST_EQUAL(opt2.result().values("tag"), 2u);
+        TEST_EQUAL(opt2.result().dropped("tag"), 2u);
+    }
+
+}
@@ -0,0 +1,96 @@
+#include "rs-options/options.hpp"
+#include "rs-unit-test.hpp"
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace RS::Option;
+
+void test_rs_options_check() {
+
+    using code = Options::error_code;
+
+    std::string s = "default";
+    std::string t = "default";
+    int i = 10;
+    int j = 20;
+    bool b = false;
+    std::vector<int> v;
+
+    Options opt1("Hello", "", "Says hello.");
+    TRY(opt1.set_colour(false));
+    TRY(opt1.add(s, "string", 's', "String option", Options::required));
+    TRY(opt1.add(t, "text", 't', "Text option", Options::required));
+    TRY(opt1.add(i, "integer", 'i', "Integer option", 0, "group"));
+    TRY(opt1.add(j, "jnteger", 'j', "Jnteger option", 0, "group"));
+    TRY(opt1.add(b, "boolean", 'b', "Boolean option"));
+    TRY(opt1.add(v, "vector", 'x', "Vector option"));
+
+    {
+        Options opt2 = opt1;
+        std::vector<Options::parse_error> errors;
+        TRY(errors = opt2.check({"--string", "hello", "--text", "world", "-i", "42", "-b", "-x", "1", "2", "3"}));
+        TEST(errors.empty());
+        TEST_EQUAL(s, "default");
+        TEST_EQUAL(t, "default");
+        TEST_EQUAL(i, 10);
+        TEST(! b);
+        TEST(v.empty());
+        TEST(! opt2.found("string"));
+        TEST(! opt2.found("integer"));
+        TEST(! opt2.found("vector"));
+    }
+
+    {
+        Options opt2 = opt1;
+        std::vector<Options::parse_error> errors;
+        TRY(errors = opt2.check({
+            "--integer", "abc",       // 0-1
+            "--jnteger", "5",         // 2-3
+            "--foo", "bar", "baz",    // 4-6
+            "-x", "1", "two", "3",    // 7-10
+            "--boolean", "--boolean", // 11-12
+            "-q",                     // 13
+        }));
+        TEST_EQUAL(errors.size(), 8u);
+        if (errors.size() == 8) {
+            TEST_EQUAL(int(errors[0].code), int(code::pattern_mismatch));      TEST_EQUAL(errors[0].index, 1u);
+            TEST_EQUAL(int(errors[1].code), int(code::mutually_exclusive));    TEST_EQUAL(errors[1].index, 2u);
+            TEST_EQUAL(int(errors[2].code), int(code::unknown_option));        TEST_EQUAL(errors[2].index, 4u);
+            TEST_EQUAL(int(errors[3].code), int(code::pattern_mismatch));      TEST_EQUAL(errors[3].index, 9u);
+            TEST_EQUAL(int(errors[4].code), int(code::repeated_option));       TEST_EQUAL(errors[4].index, 12u);
+            TEST_EQUAL(int(errors[5].code), int(code::unknown_option));        TEST_EQUAL(errors[5].index, 13u);
+            TEST_EQUAL(int(errors[6].code), int(code::required_missing));      TEST_EQUAL(errors[6].option, "string");
+            TEST_EQUAL(int(errors[7].code), int(code::required_missing));      TEST_EQUAL(errors[7].option, "text");
+            TEST_EQUAL(opt2.error_message(errors[3]), "Argument does not match expected pattern: \"two\"");
+        }
+        TEST_EQUAL(i, 10);
+        TEST_EQUAL(j, 20);
+        TEST(v.empty());
+        TEST(! opt2.found("integer"));
+    }
+
+    {
+        Options opt2 = opt1;
+        std::vector<Options::parse_error> errors;
+        TRY(errors = opt2.check({"--help"}));
+        TEST(errors.empty());
+        TEST(! opt2.found("help"));
+    }
+
+    {
+        // A dry run can be followed by a real parse
+        Options opt2 = opt1;
+        std::vector<Options::parse_error> errors;
+        TRY(errors = opt2.check({"-s", "hello", "-t", "world", "-j", "99"}));
+        TEST(errors.empty());
+        TEST_EQUAL(j, 20);
+        std::ostringstream out;
+        TEST(opt2.parse({"-s", "hello", "-t", "world", "-j", "99"}, out));
+        TEST_EQUAL(j, 99);
+        TEST(opt2.found("jnteger"));
+    }
+
+}
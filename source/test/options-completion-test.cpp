@@ -0,0 +1,130 @@
+#include "rs-options/options.hpp"
+#include "rs-tl/enum.hpp"
+#include "rs-unit-test.hpp"
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace RS::Option;
+
+RS_DEFINE_ENUM_CLASS(Flavour, int, 1, vanilla, chocolate, strawberry)
+
+void test_rs_options_completion() {
+
+    bool verbose = false;
+    int count = 0;
+    Flavour flavour = Flavour::vanilla;
+    std::vector<std::string> files;
+
+    Options opt1("Hello", "", "Says hello.");
+    TRY(opt1.set_colour(false));
+    TRY(opt1.add(verbose, "verbose", 'V', "Verbose option"));
+    TRY(opt1.add(count, "count", 'c', "Count option"));
+    TRY(opt1.add(flavour, "flavour", 'f', "Flavour option"));
+    TRY(opt1.add(files, "files", 0, "Input files", Options::anon));
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST(! opt2.parse({Options::complete_option, "--"}, out));
+        TEST_EQUAL(out.str(),
+            "--count\n"
+            "--files\n"
+            "--flavour\n"
+            "--help\n"
+            "--no-help\n"
+            "--no-verbose\n"
+            "--no-version\n"
+            "--verbose\n"
+            "--version\n"
+        );
+    }
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST(! opt2.parse({Options::complete_option, "--count", "5", "--ve"}, out));
+        TEST_EQUAL(out.str(),
+            "--verbose\n"
+            "--version\n"
+        );
+    }
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST(! opt2.parse({Options::complete_option, "--flavour", ""}, out));
+        TEST_EQUAL(out.str(),
+            "vanilla\n"
+            "chocolate\n"
+            "strawberry\n"
+        );
+    }
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST(! opt2.parse({Options::complete_option, "-f", "ch"}, out));
+        TEST_EQUAL(out.str(), "chocolate\n");
+    }
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST(! opt2.parse({Options::complete_option, "--flavour=s"}, out));
+        TEST_EQUAL(out.str(), "--flavour=strawberry\n");
+    }
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST(! opt2.parse({Options::complete_option, "--count", ""}, out));
+        TEST_EQUAL(out.str(), "");
+    }
+
+    {
+        std::string script;
+        TRY(script = opt1.completion_script(Options::shell_type::bash, "hello"));
+        TEST_MATCH(script, R"(^_hello_complete\(\) \{\n)");
+        TEST_MATCH(script, R"(\n        --flavour\|-'f'\)\n            COMPREPLY=\(\$\(compgen -W 'vanilla chocolate strawberry' -- "\$cur"\)\)\n)");
+        TEST_MATCH(script, R"(compgen -W '--verbose --no-verbose --count --flavour --files --help --no-help --version --no-version')");
+        TEST_MATCH(script, R"(\ncomplete -o default -F _hello_complete 'hello'\n$)");
+    }
+
+    {
+        std::string script;
+        TRY(script = opt1.completion_script(Options::shell_type::fish, "hello"));
+        TEST_EQUAL(script,
+            "complete -c 'hello' -l 'verbose' -s 'V' -d 'Verbose option'\n"
+            "complete -c 'hello' -l 'count' -s 'c' -r -d 'Count option'\n"
+            "complete -c 'hello' -l 'flavour' -s 'f' -x -a 'vanilla chocolate strawberry' -d 'Flavour option'\n"
+            "complete -c 'hello' -l 'files' -r -d 'Input files'\n"
+            "complete -c 'hello' -l 'help' -s 'h' -d 'Show usage information'\n"
+            "complete -c 'hello' -l 'version' -s 'v' -d 'Show version information'\n"
+        );
+    }
+
+    {
+        std::string script;
+        TRY(script = opt1.completion_script(Options::shell_type::zsh, "hello"));
+        TEST_EQUAL(script,
+            "#compdef hello\n"
+            "\n"
+            "_arguments -s \\\n"
+            "    '--verbose[Verbose option]' \\\n"
+            "    '-V[Verbose option]' \\\n"
+            "    '--count[Count option]:<int>: ' \\\n"
+            "    '-c[Count option]:<int>: ' \\\n"
+            "    '--flavour[Flavour option]:<arg>:(vanilla chocolate strawberry)' \\\n"
+            "    '-f[Flavour option]:<arg>:(vanilla chocolate strawberry)' \\\n"
+            "    '*--files[Input files]:<arg>:_files' \\\n"
+            "    '--help[Show usage information]' \\\n"
+            "    '-h[Show usage information]' \\\n"
+            "    '--version[Show version information]' \\\n"
+            "    '-v[Show version information]'\n"
+        );
+    }
+
+}
@@ -0,0 +1,106 @@
+#include "rs-options/options.hpp"
+#include "rs-tl/enum.hpp"
+#include "rs-unit-test.hpp"
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace RS::Option;
+
+RS_DEFINE_ENUM_CLASS(Shape, int, 1, circle, square, triangle, hexagon)
+
+void test_rs_options_constraint() {
+
+    int count = 10;
+    double ratio = 0;
+    std::string name;
+    std::string mode = "fast";
+    Shape shape = Shape::circle;
+    std::vector<int> ports;
+
+    Options opt1("Hello", "", "Says hello.");
+    TRY(opt1.set_colour(false));
+    TRY(opt1.add(count, "count", 'c', "Count option", 0, {}, Constraint<int>::range(1, 100)));
+    TRY(opt1.add(ratio, "ratio", 'r', "Ratio option", 0, {}, Constraint<double>::at_most(1.0)));
+    TRY(opt1.add(name, "name", 'n', "Name option", 0, {}, Constraint<std::string>::length(2, 8)));
+    TRY(opt1.add(mode, "mode", 'm', "Mode option", 0, {}, Constraint<std::string>::one_of({"fast", "slow", "safe"})));
+    TRY(opt1.add(shape, "shape", 's', "Shape option", 0, {}, Constraint<Shape>::one_of({Shape::circle, Shape::square})));
+    TRY(opt1.add(ports, "ports", 'p', "Port numbers", 0, {}, Constraint<int>::at_least(1024)));
+
+    {
+        Options opt2 = opt1;
+        TRY(opt2.auto_help());
+        std::ostringstream out;
+        TEST(! opt2.parse({}, out));
+        TEST_EQUAL(out.str(),
+            "\n"
+            "Hello\n"
+            "\n"
+            "Says hello.\n"
+            "\n"
+            "Options:\n"
+            "    --count, -c <int>      = Count option (1 to 100; default 10)\n"
+            "    --ratio, -r <real>     = Ratio option (at most 1)\n"
+            "    --name, -n <arg>       = Name option (length 2 to 8)\n"
+            "    --mode, -m <arg>       = Mode option (one of fast, slow, safe; default \"fast\")\n"
+            "    --shape, -s <arg>      = Shape option (one of circle, square; default circle)\n"
+            "    --ports, -p <int> ...  = Port numbers (at least 1024)\n"
+            "    --help, -h             = Show usage information\n"
+            "    --version, -v          = Show version information\n"
+            "\n"
+        );
+    }
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST(opt2.parse({"-c", "100", "-r", "0.5", "-n", "abcdefgh", "-m", "safe", "-s", "square", "-p", "1024", "8080"}, out));
+        TEST_EQUAL(count, 100);
+        TEST_EQUAL(ratio, 0.5);
+        TEST_EQUAL(name, "abcdefgh");
+        TEST_EQUAL(mode, "safe");
+        TEST_EQUAL(shape, Shape::square);
+        TEST_EQUAL(ports.size(), 2u);
+    }
+
+    struct test_case {
+        std::vector<std::string> args;
+        std::string message;
+    };
+
+    std::vector<test_case> cases = {
+        { {"-c", "0"},               R"(^Argument to --count is not 1 to 100: "0"$)" },
+        { {"-c", "101"},             R"(^Argument to --count is not 1 to 100: "101"$)" },
+        { {"-r", "1.5"},             R"(^Argument to --ratio is not at most 1: "1.5"$)" },
+        { {"-n", "a"},               R"(^Argument to --name is not length 2 to 8: "a"$)" },
+        { {"-n", "abcdefghi"},       R"(^Argument to --name is not length 2 to 8: "abcdefghi"$)" },
+        { {"-m", "quick"},           R"(^Argument to --mode is not one of fast, slow, safe: "quick"$)" },
+        { {"-s", "triangle"},        R"(^Argument to --shape is not one of circle, square: "triangle"$)" },
+        { {"-p", "8080", "80"},      R"(^Argument to --ports is not at least 1024: "80"$)" },
+    };
+
+    for (auto& c: cases) {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        auto status = opt2.try_parse(c.args, out);
+        TEST(! status);
+        TEST_EQUAL(int(status.error().code), int(Options::error_code::constraint_failed));
+        TEST_MATCH(opt2.error_message(status.error()), c.message);
+    }
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST(! opt2.parse({Options::complete_option, "--mode", "s"}, out));
+        TEST_EQUAL(out.str(), "slow\nsafe\n");
+    }
+
+    {
+        int n = 500;
+        Options opt2("Hello", "", "Says hello.");
+        TEST_THROW(opt2.add(n, "number", 0, "Number option", 0, {}, Constraint<int>::range(1, 100)), Options::setup_error);
+    }
+
+}
@@ -0,0 +1,147 @@
+#include "rs-options/options.hpp"
+#include "rs-unit-test.hpp"
+#include <string>
+#include <vector>
+
+using namespace RS::Option;
+
+namespace {
+
+    // Flattens each event into "name=value@index", or "!code@index" for an error
+
+    template <typename Range>
+    std::string describe(Range&& range, size_t limit = 100) {
+        std::string out;
+        size_t n = 0;
+        for (auto& ev: range) {
+            if (! out.empty())
+                out += ' ';
+            if (ev.error == Options::error_code::none)
+                out += std::string(ev.name) + '=' + std::string(ev.value);
+            else
+                out += '!' + std::to_string(int(ev.error)) + ':' + std::string(ev.value);
+            out += '@' + std::to_string(ev.index);
+            if (++n == limit)
+                break;
+        }
+        return out;
+    }
+
+}
+
+void test_rs_options_events() {
+
+    using code = Options::error_code;
+
+    std::string s;
+    int n = 0;
+    bool b = false;
+    bool c = false;
+    std::vector<std::string> v;
+    std::vector<std::string> f;
+
+    Options opt("Hello", "1.0", "Says hello.");
+    TRY(opt.add(s, "string", 's', "String option"));
+    TRY(opt.add(n, "number", 'n', "Number option"));
+    TRY(opt.add(b, "bool", 'b', "Boolean option"));
+    TRY(opt.add(c, "check", 'c', "Another boolean option"));
+    TRY(opt.add(v, "vector", 'x', "Vector option"));
+    TRY(opt.add(f, "file", '\0', "File option", Options::anon));
+
+    TEST_EQUAL(describe(opt.events({})), "");
+    TEST_EQUAL(describe(opt.events({"-s", "hello", "--number=42"})), "string=hello@1 number=42@2");
+    TEST_EQUAL(describe(opt.events({"-b", "--no-check", "-b", "--bool=no"})), "bool=t@0 check=f@1 bool=t@2 bool=f@3");
+    TEST_EQUAL(describe(opt.events({"-bcs", "abc"})), "bool=t@0 check=t@0 string=abc@1");
+    TEST_EQUAL(describe(opt.events({"-x", "a", "b", "--vector=c", "d", "-b"})),
+        "vector=a@1 vector=b@2 vector=c@3 vector=d@4 bool=t@5");
+    TEST_EQUAL(describe(opt.events({"one", "-s", "x", "two"})), "file=one@0 string=x@2 file=two@3");
+    TEST_EQUAL(describe(opt.events({"-s", "--", "-x", "-b"})), "string=-x@2 file=-b@3");
+    TEST_EQUAL(describe(opt.events({"-s", "-b", "-n"})), "string=@0 bool=t@1 number=@2");
+    TEST_EQUAL(describe(opt.events({"-sb"})), "string=@0 bool=t@0");
+    TEST_EQUAL(describe(opt.events({"--help"})), "help=t@0");
+
+    // Repeated options are reported, not rejected, and nothing is converted
+
+    TEST_EQUAL(describe(opt.events({"-n", "x", "-n", "y"})), "number=x@1 number=y@3");
+    TEST_EQUAL(n, 0);
+
+    // Errors are events; arguments following a bad option are skipped
+
+    TEST_EQUAL(describe(opt.events({"--nonsense", "x", "-b"})),
+        "!" + std::to_string(int(code::unknown_option)) + ":--nonsense@0 bool=t@2");
+    TEST_EQUAL(describe(opt.events({"-bq", "x", "-c"})),
+        "bool=t@0 !" + std::to_string(int(code::unknown_option)) + ":-bq@0 check=t@2");
+    TEST_EQUAL(describe(opt.events({"--bool=maybe"})),
+        "!" + std::to_string(int(code::invalid_argument)) + ":maybe@0");
+
+    {
+        std::vector<std::string> args = {"--bool=maybe"};
+        auto range = opt.events(args);
+        auto it = range.begin();
+        TEST(it != range.end());
+        TEST_EQUAL(it->option, 2u);
+        TEST_EQUAL(it->name, "bool");
+        TEST_EQUAL(int(it->error), int(code::invalid_argument));
+    }
+
+    {
+        Options opt2("Hello", "1.0", "Says hello.");
+        TRY(opt2.add(s, "string", 's', "String option"));
+        TEST_EQUAL(describe(opt2.events({"x"})), "!" + std::to_string(int(code::unassigned_argument)) + ":x@0");
+    }
+
+    // The caller may stop early; the range resumes from the current event
+
+    {
+        std::vector<std::string> args = {"-b", "-c", "-s", "abc", "-n", "1"};
+        auto range = opt.events(args);
+        TEST_EQUAL(describe(range, 2), "bool=t@0 check=t@1");
+        TEST_EQUAL(describe(range), "check=t@1 string=abc@3 number=1@5");
+        TEST_EQUAL(describe(range), "");
+        TEST(range.begin() == range.end());
+    }
+
+    // Values refer to the original arguments
+
+    {
+        char arg0[] = "hello";
+        char arg1[] = "--string=xyz";
+        char arg2[] = "-n";
+        char arg3[] = "99";
+        char* argv[] = {arg0, arg1, arg2, arg3, nullptr};
+        auto range = opt.events(4, argv);
+        auto it = range.begin();
+        TEST(it != range.end());
+        TEST_EQUAL(it->option, 0u);
+        TEST_EQUAL(it->value, "xyz");
+        TEST(it->value.data() == arg1 + 9);
+        ++it;
+        TEST(it != range.end());
+        TEST_EQUAL(it->option, 1u);
+        TEST(it->value.data() == arg3);
+        TEST_EQUAL(it->index, 2u);
+        ++it;
+        TEST(it == range.end());
+    }
+
+    // A temporary argument list is kept alive by the range
+
+    {
+        auto range = opt.events(std::vector<std::string>{"--string", "a value too long for the short string buffer", "-b"});
+        auto it = range.begin();
+        TEST(it != range.end());
+        TEST_EQUAL(it->value, "a value too long for the short string buffer");
+        TEST_EQUAL(describe(range), "string=a value too long for the short string buffer@1 bool=t@2");
+    }
+
+    // Options loaded from a spec don't need variables
+
+    {
+        std::string spec;
+        TRY(spec = opt.save_spec());
+        Options opt2;
+        TRY(opt2 = Options::load_spec(spec));
+        TEST_EQUAL(describe(opt2.events({"-x", "a", "-b"})), "vector=a@1 bool=t@2");
+    }
+
+}
@@ -0,0 +1,113 @@
+#include "rs-options/options.hpp"
+#include "rs-unit-test.hpp"
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace RS::Option;
+
+void test_rs_options_fast_exit() {
+
+    std::string s;
+    bool b = false;
+
+    Options opt1("Hello", "1.0", "Says hello.");
+    TRY(opt1.set_colour(false));
+    TRY(opt1.add(s, "string", 's', "String option", Options::required));
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST(! opt2.parse({"--version"}, out));
+        TEST_EQUAL(out.str(), "Hello 1.0\n");
+    }
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST(! opt2.parse({"-v"}, out));
+        TEST_EQUAL(out.str(), "Hello 1.0\n");
+    }
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST(! opt2.parse({"-h"}, out));
+        TEST_EQUAL(out.str(),
+            "\n"
+            "Hello 1.0\n"
+            "\n"
+            "Says hello.\n"
+            "\n"
+            "Options:\n"
+            "    --string, -s <arg>  = String option (required)\n"
+            "    --help, -h          = Show usage information\n"
+            "    --version, -v       = Show version information\n"
+            "\n"
+        );
+    }
+
+    {
+        char arg0[] = "hello";
+        char arg1[] = "--version";
+        char* argv[] = {arg0, arg1, nullptr};
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST(! opt2.parse(2, argv, out));
+        TEST_EQUAL(out.str(), "Hello 1.0\n");
+    }
+
+    // The found flags are set as they would be by a full parse
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST(! opt2.parse({"--help"}, out));
+        TEST(opt2.found("help"));
+        TEST(! opt2.found("version"));
+        TEST(opt2.result().found("help"));
+        TEST(! opt2.parse({"-v"}, out));
+        TEST(opt2.found("version"));
+        TEST(! opt2.found("help"));
+        TEST(! opt2.found("string"));
+        TEST(opt2.result().found("version"));
+        TEST(! opt2.result().found("help"));
+    }
+
+    // The fast path only applies to a lone argument
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST(! opt2.parse({"--version", "-s", "x"}, out));
+        TEST_EQUAL(out.str(), "Hello 1.0\n");
+        TEST_EQUAL(s, "x");
+    }
+
+    // Short forms belong to user options when they are taken
+
+    {
+        Options opt2 = opt1;
+        TRY(opt2.add(b, "verbose", 'v', "Verbose option"));
+        std::ostringstream out;
+        TEST_THROW_MATCH(opt2.parse({"-v"}, out), Options::user_error, "Required option not found: --string");
+        TEST_EQUAL(out.str(), "");
+        TEST(! opt2.parse({"--version"}, out));
+        TEST_EQUAL(out.str(), "Hello 1.0\n");
+    }
+
+    // No option needs a variable to answer a version request
+
+    {
+        std::string spec;
+        TRY(spec = opt1.save_spec());
+        Options opt2 = opt1;
+        TRY(opt2 = Options::load_spec(spec));
+        std::ostringstream out;
+        TEST(! opt2.parse({"-v"}, out));
+        TEST_EQUAL(out.str(), "Hello 1.0\n");
+        TEST_THROW(opt2.parse({"-s", "x"}, out), Options::setup_error);
+    }
+
+}
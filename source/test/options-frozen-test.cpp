@@ -0,0 +1,120 @@
+#include "rs-options/options.hpp"
+#include "rs-unit-test.hpp"
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace RS::Option;
+
+void test_rs_options_frozen() {
+
+    bool flag = false;
+    int count = 0;
+    std::string name;
+    std::vector<double> values;
+
+    Options opt1("Hello", "", "Says hello.");
+    TRY(opt1.set_colour(false));
+    TRY(opt1.add(flag, "flag", 'f', "Flag option"));
+    TRY(opt1.add(count, "count", 'c', "Count option"));
+    TRY(opt1.add(name, "name", 'n', "Name option"));
+    TRY(opt1.add(values, "values", 'x', "Value list", Options::anon));
+
+    std::vector<uint64_t> block;
+    size_t bytes = 0;
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST(opt2.parse({"1.5", "-c", "42", "2.5", "--no-flag", "--values=3.5", "-x", "4.5"}, out));
+        auto& r = opt2.result();
+        TRY(bytes = r.frozen_size());
+        block.resize((bytes + 7) / 8);
+        TRY(r.freeze(block.data()));
+    }
+
+    // The block is position independent, and outlives the Options object
+
+    std::vector<uint64_t> moved(block.size());
+    std::memcpy(moved.data(), block.data(), bytes);
+    block.assign(block.size(), 0);
+
+    Options::frozen_result f;
+    TRY(f = Options::frozen_result(moved.data(), bytes));
+
+    TEST_EQUAL(f.size(), 6u);
+    TEST_EQUAL(f.index("flag"), 0u);
+    TEST_EQUAL(f.index("--values"), 3u);
+    TEST_EQUAL(f.index("version"), 5u);
+    TEST_EQUAL(f.index("nothing"), std::string::npos);
+    TEST_EQUAL(f.name(2), "name");
+
+    TEST(f.found("flag"));
+    TEST(f.found("count"));
+    TEST(! f.found("name"));
+    TEST(f.found("values"));
+    TEST(! f.found("help"));
+    TEST(! f.found("nothing"));
+
+    TEST_EQUAL(f.count("values"), 4u);
+    TEST_EQUAL(f.values("name"), 0u);
+    TEST_EQUAL(f.values("values"), 4u);
+
+    TEST_EQUAL(f.value("count"), "42");
+    TEST_EQUAL(f.value("values", 0), "1.5");
+    TEST_EQUAL(f.value("values", 3), "4.5");
+    TEST_EQUAL(f.value("values", 4), "");
+    TEST_EQUAL(f.value("name"), "");
+    TEST_EQUAL(f.value("flag"), "f");
+
+    TEST(f.get<bool>("flag") == false);
+    TEST(f.get<int>("count") == 42);
+    TEST(f.get<double>("values", 2) == 3.5);
+    TEST(! f.get<int>("name"));
+
+    // Values are read in place
+
+    {
+        auto view = f.value("count");
+        auto base = reinterpret_cast<const char*>(moved.data());
+        TEST(view.data() >= base && view.data() < base + bytes);
+    }
+
+    // An empty result can be frozen too
+
+    {
+        Options::parse_result r;
+        std::vector<uint64_t> empty((r.frozen_size() + 7) / 8);
+        TRY(r.freeze(empty.data()));
+        Options::frozen_result g;
+        TRY(g = Options::frozen_result(empty.data(), r.frozen_size()));
+        TEST_EQUAL(g.size(), 0u);
+        TEST(! g.found("flag"));
+        TEST_EQUAL(g.value("flag"), "");
+    }
+
+    {
+        Options::frozen_result g;
+        TEST_EQUAL(g.size(), 0u);
+        TEST_EQUAL(g.index("flag"), std::string::npos);
+    }
+
+    // Damaged blocks are rejected
+
+    TEST_THROW(Options::frozen_result(nullptr, 0), Options::setup_error);
+    TEST_THROW(Options::frozen_result(moved.data(), 16), Options::setup_error);
+    TEST_THROW(Options::frozen_result(moved.data(), bytes - 1), Options::setup_error);
+    TEST_THROW(Options::frozen_result(reinterpret_cast<const char*>(moved.data()) + 1, bytes - 1), Options::setup_error);
+
+    {
+        auto damaged = moved;
+        damaged[0] ^= 1;
+        TEST_THROW(Options::frozen_result(damaged.data(), bytes), Options::setup_error);
+        damaged = moved;
+        damaged[6] = 1000;
+        TEST_THROW(Options::frozen_result(damaged.data(), bytes), Options::setup_error);
+    }
+
+}
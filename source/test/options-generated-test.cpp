@@ -0,0 +1,140 @@
+#include "options-generated.hpp"
+#include "rs-options/options.hpp"
+#include "rs-format/format.hpp"
+#include "rs-unit-test.hpp"
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace RS::Format;
+using namespace RS::Option;
+using namespace RS::Option::Test;
+
+void test_rs_options_generated() {
+
+    GeneratedOptions g;
+    std::ostringstream out;
+
+    TEST_EQUAL(g.name, "world");
+    TEST_EQUAL(g.count, 1);
+    TEST_EQUAL(g.limit, 0u);
+    TEST_EQUAL(g.scale, 1.5);
+    TEST(! g.loud);
+    TEST(g.files.empty());
+    TEST_EQUAL(g.ceiling, std::numeric_limits<double>::infinity());
+    TEST(std::isnan(g.offset));
+    TEST(! g.tick);
+    TEST_EQUAL(g.retries, 10);
+    TEST_EQUAL(g.maximum, std::numeric_limits<std::uint64_t>::max());
+    TEST_EQUAL(g.minimum, std::numeric_limits<std::int64_t>::min());
+
+    TEST(g.parse({"--name", "alice", "-c", "3", "--limit=1000", "-ls", "2.5e1", "a.txt", "b.txt"}, out));
+    TEST_EQUAL(out.str(), "");
+    TEST_EQUAL(g.name, "alice");
+    TEST_EQUAL(g.count, 3);
+    TEST_EQUAL(g.limit, 1000u);
+    TEST_EQUAL(g.scale, 25.0);
+    TEST(g.loud);
+    TEST(! g.quiet);
+    TEST_EQUAL(format_range(g.files), "[a.txt,b.txt]");
+    TEST(g.found("name"));
+    TEST(g.found("--scale"));
+    TEST(! g.found("quiet"));
+    TEST(! g.found("nonsense"));
+
+    // Each parse starts from the defaults
+
+    TEST(g.parse({"-q", "--dry-run", "1", "2", "--", "-3"}, out));
+    TEST_EQUAL(g.name, "world");
+    TEST_EQUAL(g.count, 1);
+    TEST(g.quiet);
+    TEST(! g.loud);
+    TEST_EQUAL(format_range(g.dry_run), "[1,2,-3]");
+    TEST(! g.found("loud"));
+    TEST(g.files.empty());
+
+    // The runtime parser, loaded from the same spec, handles everything
+    // else, so errors are reported exactly as usual
+
+    TEST(g.parse({"-d", "1", "-c", "+5"}, out));
+    TEST_EQUAL(format_range(g.dry_run), "[1]");
+    TEST_EQUAL(g.count, 5);
+    TEST_THROW(g.parse({"-d", "1", "-2"}, out), Options::user_error);
+    TEST_THROW_MATCH(g.parse({"--name", "Alice"}, out), Options::user_error, "\"Alice\"");
+    TEST_THROW_MATCH(g.parse({"--count", "many"}, out), Options::user_error, "\"many\"");
+    TEST_THROW(g.parse({"--nonsense"}, out), Options::user_error);
+    TEST_THROW(g.parse({"-q", "--silent"}, out), Options::user_error);
+    TEST_THROW(g.parse({"-c", "1", "-c", "2"}, out), Options::user_error);
+    TEST_EQUAL(g.name, "world");
+    TEST_EQUAL(format_range(g.dry_run), "[1]");
+
+    TEST(g.parse({"--loud=no", "--name=bob"}, out));
+    TEST(! g.loud);
+    TEST(g.found("loud"));
+    TEST_EQUAL(g.name, "bob");
+
+    // Abbreviations that need escaping in a character literal
+
+    TEST(g.parse({"-\\", "2.5", "-'"}, out));
+    TEST_EQUAL(g.ceiling, 2.5);
+    TEST(g.tick);
+    TEST(g.found("ceiling"));
+    TEST(g.parse({"-'\\", "3"}, out));
+    TEST_EQUAL(g.ceiling, 3.0);
+    TEST(g.tick);
+
+    // Help and version text are the same as the runtime parser's
+
+    {
+        std::string name;
+        int count = 1;
+        std::uint64_t limit = 0;
+        double scale = 1.5;
+        bool loud = false, quiet = false, silent = false;
+        std::vector<std::string> files;
+        std::vector<int> dry_run;
+        double ceiling = std::numeric_limits<double>::infinity();
+        double offset = std::numeric_limits<double>::quiet_NaN();
+        bool tick = false;
+        int retries = 10;
+        std::uint64_t maximum = std::numeric_limits<std::uint64_t>::max();
+        std::int64_t minimum = std::numeric_limits<std::int64_t>::min();
+        Options opt("Hello", "1.0", "Says hello.");
+        TRY(opt.set_colour(false));
+        name = "world";
+        TRY(opt.add(name, "name", 'n', "Name to greet", 0, {}, "[a-z]+"));
+        TRY(opt.add(count, "count", 'c', "Number of greetings"));
+        TRY(opt.add(limit, "limit", '\0', "Upper limit"));
+        TRY(opt.add(scale, "scale", 's', "Scale factor"));
+        TRY(opt.add(loud, "loud", 'l', "Shout the greeting"));
+        TRY(opt.add(quiet, "quiet", 'q', "Whisper the greeting", 0, "volume"));
+        TRY(opt.add(silent, "silent", '\0', "Say nothing", 0, "volume"));
+        TRY(opt.add(files, "files", '\0', "Input files", Options::anon));
+        TRY(opt.add(dry_run, "dry-run", 'd', "Numbers to try"));
+        TRY(opt.add(ceiling, "ceiling", '\\', "Largest value"));
+        TRY(opt.add(offset, "offset", '\0', "Offset to apply"));
+        TRY(opt.add(tick, "tick", '\'', "Mark the greeting"));
+        TRY(opt.add(retries, "retries", '\0', "Number of retries"));
+        TRY(opt.add(maximum, "maximum", '\0', "Largest count"));
+        TRY(opt.add(minimum, "minimum", '\0', "Smallest count"));
+        std::ostringstream help;
+        TEST(! opt.parse({"--help"}, help));
+        TEST_EQUAL(GeneratedOptions::help_text, help.str());
+    }
+
+    out.str({});
+    TEST(! g.parse({"-h"}, out));
+    TEST_EQUAL(out.str(), GeneratedOptions::help_text);
+    out.str({});
+    TEST(! g.parse({"--version"}, out));
+    TEST_EQUAL(out.str(), "Hello 1.0\n");
+    TEST_EQUAL(GeneratedOptions::version_text, "Hello 1.0\n");
+
+    out.str({});
+    TEST(! g.parse({RS::Option::Options::complete_option, "--na"}, out));
+    TEST_MATCH(out.str(), "--name");
+
+}
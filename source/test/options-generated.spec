@@ -0,0 +1,72 @@
+# Option spec for options-generated-test.cpp
+
+struct GeneratedOptions
+namespace RS::Option::Test
+app Hello
+version 1.0
+description Says hello.
+
+option string name
+    abbrev n
+    description Name to greet
+    default world
+    pattern [a-z]+
+
+option int count
+    abbrev c
+    description Number of greetings
+    default 1
+
+option uint64 limit
+    description Upper limit
+
+option double scale
+    abbrev s
+    description Scale factor
+    default 1.5
+
+option bool loud
+    abbrev l
+    description Shout the greeting
+
+option bool quiet
+    abbrev q
+    description Whisper the greeting
+    group volume
+
+option bool silent
+    description Say nothing
+    group volume
+
+option vector<string> files
+    description Input files
+    flags anon
+
+option vector<int> dry-run
+    abbrev d
+    description Numbers to try
+
+option double ceiling
+    abbrev \
+    description Largest value
+    default inf
+
+option double offset
+    description Offset to apply
+    default nan
+
+option bool tick
+    abbrev '
+    description Mark the greeting
+
+option int retries
+    description Number of retries
+    default 010
+
+option uint64 maximum
+    description Largest count
+    default 18446744073709551615
+
+option int64 minimum
+    description Smallest count
+    default -9223372036854775808
@@ -0,0 +1,102 @@
+#include "rs-options/options.hpp"
+#include "rs-unit-test.hpp"
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace RS::Option;
+
+void test_rs_options_interned_strings() {
+
+    InternedStrings s;
+
+    TEST(s.empty());
+    TEST_EQUAL(s.size(), 0u);
+    TEST_EQUAL(s.distinct(), 0u);
+
+    TRY(s.push_back("alpha"));
+    TRY(s.push_back("bravo"));
+    TRY(s.push_back("alpha"));
+    TRY(s.insert(s.begin(), "charlie"));
+
+    TEST_EQUAL(s.size(), 4u);
+    TEST_EQUAL(s.distinct(), 3u);
+    TEST_EQUAL(s[0], "charlie");
+    TEST_EQUAL(s[1], "alpha");
+    TEST_EQUAL(s[2], "bravo");
+    TEST_EQUAL(s[3], "alpha");
+    TEST_EQUAL(s.id(1), s.id(3));
+    TEST(s.ids() == std::vector<uint32_t>({2, 0, 1, 0}));
+    TEST_EQUAL(s.symbol(2), "charlie");
+    TEST(s.find("bravo") == 1u);
+    TEST(! s.find("delta"));
+
+    std::vector<std::string> v(s.begin(), s.end());
+    TEST(v == std::vector<std::string>({"charlie", "alpha", "bravo", "alpha"}));
+
+    InternedStrings t = s;
+    TRY(s.clear());
+    TEST(s.empty());
+    TEST_EQUAL(t.size(), 4u);
+    TEST(t.find("alpha") == 0u);
+    TEST_EQUAL(t.intern("charlie"), 2u);
+
+}
+
+void test_rs_options_interned_arguments() {
+
+    InternedStrings tags;
+    InternedStrings files;
+
+    Options opt1("Hello", "", "Says hello.");
+    TRY(opt1.set_colour(false));
+    TRY(opt1.add(tags, "tag", 't', "Tag list", 0, {}, Constraint<std::string>::length(1, 5)));
+    TRY(opt1.add(files, "files", 'f', "File list", Options::anon | Options::parallel));
+
+    {
+        Options opt2 = opt1;
+        TRY(opt2.auto_help());
+        std::ostringstream out;
+        TEST(! opt2.parse({}, out));
+        TEST_EQUAL(out.str(),
+            "\n"
+            "Hello\n"
+            "\n"
+            "Says hello.\n"
+            "\n"
+            "Options:\n"
+            "    --tag, -t <arg> ...      = Tag list (length 1 to 5)\n"
+            "    [--files, -f] <arg> ...  = File list\n"
+            "    --help, -h               = Show usage information\n"
+            "    --version, -v            = Show version information\n"
+            "\n"
+        );
+    }
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        std::vector<std::string> args;
+        for (int i = 0; i < 10'000; ++i)
+            args.push_back("file" + std::to_string(i % 10));
+        args.insert(args.end(), {"--tag", "red", "green", "red", "--tag=blue"});
+        TEST(opt2.parse(args, out));
+        TEST_EQUAL(tags.size(), 4u);
+        TEST_EQUAL(tags.distinct(), 3u);
+        TEST_EQUAL(tags[3], "blue");
+        TEST_EQUAL(files.size(), 10'000u);
+        TEST_EQUAL(files.distinct(), 10u);
+        TEST_EQUAL(files[9'999], "file9");
+    }
+
+    {
+        tags.clear();
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST_THROW_MATCH(opt2.parse({"--tag", "yellow"}, out), Options::user_error, "yellow");
+        TEST(tags.empty());
+    }
+
+}
@@ -0,0 +1,104 @@
+#include "rs-options/options.hpp"
+#include "rs-tl/enum.hpp"
+#include "rs-unit-test.hpp"
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace RS::Option;
+
+namespace {
+
+    RS_DEFINE_ENUM_CLASS(Colour, int, 1, red, green, blue)
+
+}
+
+void test_rs_options_lazy() {
+
+    Lazy<int> count(10);
+    Lazy<double> ratio;
+    Lazy<std::string> name;
+    Lazy<Colour> colour(Colour::red);
+
+    TEST(! count.has_token());
+    TEST_EQUAL(*count, 10);
+    TEST_EQUAL(*ratio, 0.0);
+    TEST_EQUAL(*name, "");
+    TEST(*colour == Colour::red);
+
+    Options opt1("Hello", "", "Says hello.");
+    TRY(opt1.set_colour(false));
+    TRY(opt1.add(count, "count", 'c', "Count option"));
+    TRY(opt1.add(ratio, "ratio", 'r', "Ratio option"));
+    TRY(opt1.add(name, "name", 'n', "Name option", 0, "", "[A-Z][a-z]+"));
+    TRY(opt1.add(colour, "colour", 'k', "Colour option"));
+
+    {
+        Options opt2 = opt1;
+        TRY(opt2.auto_help());
+        std::ostringstream out;
+        TEST(! opt2.parse({}, out));
+        TEST_EQUAL(out.str(),
+            "\n"
+            "Hello\n"
+            "\n"
+            "Says hello.\n"
+            "\n"
+            "Options:\n"
+            "    --count, -c <int>   = Count option (default 10)\n"
+            "    --ratio, -r <real>  = Ratio option\n"
+            "    --name, -n <arg>    = Name option\n"
+            "    --colour, -k <arg>  = Colour option (default red)\n"
+            "    --help, -h          = Show usage information\n"
+            "    --version, -v       = Show version information\n"
+            "\n"
+        );
+    }
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST(opt2.parse({"-c", "42", "--ratio=0.5", "-n", "Alice", "-k", "blue"}, out));
+        TEST(count.has_token());
+        TEST_EQUAL(count.token(), "42");
+        TEST_EQUAL(ratio.token(), "0.5");
+        TEST_EQUAL(*count, 42);
+        TEST_EQUAL(*ratio, 0.5);
+        TEST_EQUAL(*name, "Alice");
+        TEST_EQUAL(name->size(), 5u);
+        TEST(*colour == Colour::blue);
+    }
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST_THROW_MATCH(opt2.parse({"-c", "abc"}, out), Options::user_error, "abc");
+        TEST_THROW_MATCH(opt1.parse({"-n", "alice"}, out), Options::user_error, "alice");
+    }
+
+    {
+        // Syntactically valid but out of range: reported on access
+
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST(opt2.parse({"-c", "99999999999999999999"}, out));
+        TEST_THROW_MATCH(*count, std::invalid_argument, "99999999999999999999");
+    }
+
+    {
+        // A lazy view refers to the argument, not to a converted copy
+
+        Lazy<std::string_view> view;
+        Options opt2("Hello", "", "Says hello.");
+        TRY(opt2.add(view, "view", 'v', "View option"));
+        std::vector<std::string> args = {"--view", "some text that is too long for the short string buffer"};
+        std::ostringstream out;
+        TEST(opt2.parse(args, out));
+        TEST_EQUAL(*view, "some text that is too long for the short string buffer");
+        TEST(view->data() == view.token().data());
+    }
+
+}
@@ -0,0 +1,154 @@
+#include "rs-options/options.hpp"
+#include "rs-unit-test.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <ostream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace RS::Option;
+
+namespace {
+
+    struct ByteSize {
+        uint64_t bytes = 0;
+        bool operator==(const ByteSize& b) const noexcept { return bytes == b.bytes; }
+        bool operator!=(const ByteSize& b) const noexcept { return bytes != b.bytes; }
+    };
+
+    std::ostream& operator<<(std::ostream& out, const ByteSize& b) {
+        return out << b.bytes << 'B';
+    }
+
+    struct Ipv4 {
+        uint32_t addr = 0;
+        bool operator==(const Ipv4& a) const noexcept { return addr == a.addr; }
+        bool operator!=(const Ipv4& a) const noexcept { return addr != a.addr; }
+    };
+
+    std::ostream& operator<<(std::ostream& out, const Ipv4& a) {
+        return out << (a.addr >> 24) << '.' << ((a.addr >> 16) & 255) << '.' << ((a.addr >> 8) & 255) << '.' << (a.addr & 255);
+    }
+
+}
+
+namespace RS::Option {
+
+    template <>
+    struct OptionTraits<ByteSize> {
+        static constexpr const char* placeholder = "<size>";
+        static bool parse(std::string_view str, ByteSize& b) noexcept {
+            uint64_t n = 0;
+            auto rc = std::from_chars(str.data(), str.data() + str.size(), n);
+            if (rc.ec != std::errc() || rc.ptr == str.data())
+                return false;
+            std::string_view suffix(rc.ptr, str.data() + str.size() - rc.ptr);
+            if (suffix == "k")
+                n <<= 10;
+            else if (suffix == "M")
+                n <<= 20;
+            else if (! suffix.empty())
+                return false;
+            b.bytes = n;
+            return true;
+        }
+    };
+
+    template <>
+    struct OptionTraits<Ipv4> {
+        static constexpr const char* placeholder = "<addr>";
+        static bool validate(std::string_view str) noexcept {
+            return std::count(str.begin(), str.end(), '.') == 3;
+        }
+        static bool parse(std::string_view str, Ipv4& a) noexcept {
+            auto ptr = str.data();
+            auto end = ptr + str.size();
+            a.addr = 0;
+            for (int i = 0; i < 4; ++i) {
+                unsigned n = 0;
+                auto rc = std::from_chars(ptr, end, n);
+                if (rc.ec != std::errc() || n > 255)
+                    return false;
+                a.addr = (a.addr << 8) | n;
+                ptr = rc.ptr;
+                if (i < 3 && (ptr == end || *ptr++ != '.'))
+                    return false;
+            }
+            return ptr == end;
+        }
+    };
+
+}
+
+void test_rs_options_option_traits() {
+
+    ByteSize size = {1024};
+    Ipv4 host;
+    std::vector<Ipv4> peers;
+    Lazy<ByteSize> limit;
+
+    Options opt1("Hello", "", "Says hello.");
+    TRY(opt1.set_colour(false));
+    TRY(opt1.add(size, "size", 's', "Buffer size"));
+    TRY(opt1.add(host, "host", 'H', "Host address"));
+    TRY(opt1.add(peers, "peers", 'p', "Peer addresses"));
+    TRY(opt1.add(limit, "limit", 'l', "Size limit"));
+
+    {
+        Options opt2 = opt1;
+        TRY(opt2.auto_help());
+        std::ostringstream out;
+        TEST(! opt2.parse({}, out));
+        TEST_EQUAL(out.str(),
+            "\n"
+            "Hello\n"
+            "\n"
+            "Says hello.\n"
+            "\n"
+            "Options:\n"
+            "    --size, -s <size>       = Buffer size (default \"1024B\")\n"
+            "    --host, -H <addr>       = Host address\n"
+            "    --peers, -p <addr> ...  = Peer addresses\n"
+            "    --limit, -l <size>      = Size limit\n"
+            "    --help, -h              = Show usage information\n"
+            "    --version, -v           = Show version information\n"
+            "\n"
+        );
+    }
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST(opt2.parse({"-s", "64k", "-H", "10.0.0.1", "-p", "192.168.1.1", "192.168.1.2", "-l", "2M"}, out));
+        TEST_EQUAL(size.bytes, 65'536u);
+        TEST_EQUAL(host.addr, 0x0a000001u);
+        TEST_EQUAL(peers.size(), 2u);
+        if (peers.size() == 2)
+            TEST_EQUAL(peers[1].addr, 0xc0a80102u);
+        TEST_EQUAL(limit->bytes, 2'097'152u);
+        auto p = opt2.result().get<Ipv4>("peers");
+        TEST(p);
+        if (p)
+            TEST_EQUAL(p->addr, 0xc0a80101u);
+    }
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        auto status = opt2.try_parse({"-s", "64q"}, out);
+        TEST(! status);
+        TEST(status.error().code == Options::error_code::invalid_argument);
+        status = opt1.try_parse({"-H", "10.0.0"}, out);
+        TEST(! status);
+        TEST(status.error().code == Options::error_code::pattern_mismatch);
+        status = opt1.try_parse({"-H", "10.0.0.256"}, out);
+        TEST(! status);
+        TEST(status.error().code == Options::error_code::invalid_argument);
+    }
+
+}
@@ -0,0 +1,156 @@
+#include "rs-options/options.hpp"
+#include "rs-unit-test.hpp"
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace RS::Option;
+
+void test_rs_options_parallel() {
+
+    bool flag = false;
+    int count = 0;
+    std::vector<int> numbers;
+    std::vector<std::string> words;
+
+    Options opt1("Hello", "", "Says hello.");
+    TRY(opt1.set_colour(false));
+    TEST_THROW(opt1.add(flag, "flag", 'f', "Flag option", Options::parallel), Options::setup_error);
+    TEST_THROW(opt1.add(count, "count", 'c', "Count option", Options::parallel), Options::setup_error);
+    TRY(opt1.add(numbers, "numbers", 'n', "Number list", Options::parallel, {}, Constraint<int>::at_most(99'999)));
+    TRY(opt1.add(words, "words", 'w', "Word list", Options::parallel, "", "[a-z]+"));
+
+    std::vector<std::string> args = {"--numbers"};
+    std::vector<int> expect;
+
+    for (int i = 0; i < 20'000; ++i) {
+        args.push_back(std::to_string(i));
+        expect.push_back(i);
+    }
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST(opt2.parse(args, out));
+        TEST_EQUAL(out.str(), "");
+        TEST(opt2.found("numbers"));
+        TEST(numbers == expect);
+    }
+
+    {
+        numbers.clear();
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST(opt2.parse({"-n", "1", "2", "-w", "abc", "--numbers=3", "-w", "xyz"}, out));
+        TEST_EQUAL(numbers.size(), 3u);
+        TEST(numbers == std::vector<int>({1, 2, 3}));
+        TEST_EQUAL(words.size(), 2u);
+        TEST(words == std::vector<std::string>({"abc", "xyz"}));
+    }
+
+    {
+        numbers.clear();
+        words.clear();
+        auto bad = args;
+        bad[15'000] = "100000";
+        bad[5'000] = "xyz";
+        Options opt2 = opt1;
+        std::ostringstream out;
+        auto status = opt2.try_parse(bad, out);
+        TEST(! status);
+        TEST(status.error().code == Options::error_code::pattern_mismatch);
+        TEST_EQUAL(status.error().index, 5'000u);
+        TEST_EQUAL(status.error().argument, "xyz");
+        TEST(numbers.empty());
+    }
+
+    {
+        auto bad = args;
+        bad[15'000] = "100000";
+        bad[5'000] = "xyz";
+        bad.push_back("-w");
+        bad.push_back("ABC");
+        Options opt2 = opt1;
+        auto errors = opt2.check(bad);
+        TEST_EQUAL(errors.size(), 3u);
+        if (errors.size() == 3) {
+            TEST(errors[0].code == Options::error_code::pattern_mismatch);
+            TEST_EQUAL(errors[0].index, 5'000u);
+            TEST(errors[1].code == Options::error_code::constraint_failed);
+            TEST_EQUAL(errors[1].index, 15'000u);
+            TEST(errors[2].code == Options::error_code::pattern_mismatch);
+            TEST_EQUAL(errors[2].argument, "ABC");
+        }
+        TEST(numbers.empty());
+        TEST(words.empty());
+    }
+
+    // Several large batches in one parse share the same worker threads
+
+    {
+        numbers.clear();
+        words.clear();
+        std::vector<std::string> both = args;
+        both.push_back("--words");
+        for (int i = 0; i < 20'000; ++i)
+            both.push_back(std::string(size_t(i % 26 + 1), char('a' + i % 26)));
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST(opt2.parse(both, out));
+        TEST(numbers == expect);
+        TEST_EQUAL(words.size(), 20'000u);
+        TEST_EQUAL(words[27], "bb");
+        TEST_EQUAL(words[19'999], std::string(6, 'f'));
+        TRY(opt2.reparse(args));
+        TEST(numbers == expect);
+        TEST(words.empty());
+    }
+
+    // The error reported is the earliest on the command line, whether or
+    // not the option that fails is parallel
+
+    {
+        std::vector<std::string> args2 = {"-x", "1", "bad", "-n", "zzz"};
+        for (int flags: {0, int(Options::parallel)}) {
+            std::vector<int> xs;
+            int num = 0;
+            Options opt2("Hello", "", "Says hello.");
+            TRY(opt2.add(xs, "xs", 'x', "X list", flags));
+            TRY(opt2.add(num, "num", 'n', "Number"));
+            std::ostringstream out;
+            auto status = opt2.try_parse(args2, out);
+            TEST(! status);
+            TEST_EQUAL(status.error().index, 2u);
+            TEST_EQUAL(status.error().option, "xs");
+            TEST_EQUAL(status.error().argument, "bad");
+            auto errors = opt2.check(args2);
+            TEST_EQUAL(errors.size(), 2u);
+            if (errors.size() == 2) {
+                TEST_EQUAL(errors[0].index, 2u);
+                TEST_EQUAL(errors[1].index, 4u);
+            }
+            TEST_THROW_MATCH(opt2.reparse(args2), Options::user_error, "\"bad\"");
+        }
+        std::vector<std::string> args3 = {"-v", "1", "abc", "-x", "xyz"};
+        for (int flags: {0, int(Options::parallel)}) {
+            std::vector<int> xs, vals;
+            Options opt2("Hello", "", "Says hello.");
+            TRY(opt2.add(xs, "xs", 'x', "X list", flags));
+            TRY(opt2.add(vals, "vals", 'v', "Value list", flags));
+            std::ostringstream out;
+            auto status = opt2.try_parse(args3, out);
+            TEST(! status);
+            TEST_EQUAL(status.error().index, 2u);
+            TEST_EQUAL(status.error().option, "vals");
+            auto errors = opt2.check(args3);
+            TEST_EQUAL(errors.size(), 2u);
+            if (errors.size() == 2) {
+                TEST_EQUAL(errors[0].option, "vals");
+                TEST_EQUAL(errors[1].option, "xs");
+            }
+        }
+    }
+
+}
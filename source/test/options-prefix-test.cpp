@@ -0,0 +1,84 @@
+#include "rs-options/options.hpp"
+#include "rs-unit-test.hpp"
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace RS::Option;
+
+void test_rs_options_prefix() {
+
+    bool verbose = false;
+    bool quiet = false;
+    int number = 0;
+    int num = 0;
+    std::string name;
+
+    Options opt1("Hello", "", "Says hello.");
+    TRY(opt1.set_colour(false));
+    TRY(opt1.add(verbose, "verbose", 0, "Verbose option"));
+    TRY(opt1.add(quiet, "quiet", 0, "Quiet option"));
+    TRY(opt1.add(number, "number", 0, "Number option"));
+    TRY(opt1.add(num, "num", 0, "Num option"));
+    TRY(opt1.add(name, "name", 0, "Name option"));
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST_THROW_MATCH(opt2.parse({"--verb"}, out), Options::user_error, "Unknown option");
+    }
+
+    Options opt3 = opt1;
+    TRY(opt3.allow_prefix());
+
+    {
+        verbose = quiet = false;
+        number = num = 0;
+        name.clear();
+        Options opt2 = opt3;
+        std::ostringstream out;
+        TEST(opt2.parse({"--verb", "--q", "--numb", "42", "--num", "86", "--na=Fred"}, out));
+        TEST(verbose);
+        TEST(quiet);
+        TEST_EQUAL(number, 42);
+        TEST_EQUAL(num, 86);
+        TEST_EQUAL(name, "Fred");
+    }
+
+    {
+        verbose = quiet = true;
+        Options opt2 = opt3;
+        std::ostringstream out;
+        TEST(opt2.parse({"--no-verb", "--no-q"}, out));
+        TEST(! verbose);
+        TEST(! quiet);
+    }
+
+    {
+        Options opt2 = opt3;
+        std::ostringstream out;
+        TEST(! opt2.parse({"--vers"}, out));
+        TEST_EQUAL(out.str(), "Hello\n");
+    }
+
+    {
+        Options opt2 = opt3;
+        std::ostringstream out;
+        TEST_THROW_MATCH(opt2.parse({"--ver"}, out), Options::user_error, "--verbose, --version");
+    }
+
+    {
+        Options opt2 = opt3;
+        std::ostringstream out;
+        TEST_THROW_MATCH(opt2.parse({"--n"}, out), Options::user_error, "--name, --no-help, --no-quiet, --no-verbose, --no-version, --num, --number");
+    }
+
+    {
+        Options opt2 = opt3;
+        std::ostringstream out;
+        TEST_THROW_MATCH(opt2.parse({"--x"}, out), Options::user_error, "Unknown option");
+    }
+
+}
@@ -0,0 +1,130 @@
+#include "rs-options/options.hpp"
+#include "rs-unit-test.hpp"
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace RS::Option;
+
+void test_rs_options_range_set_class() {
+
+    RangeSet<int> set;
+    std::optional<RangeSet<int>> opt;
+
+    TEST(set.empty());
+    TEST_EQUAL(set.str(), "");
+    TEST(set.begin() == set.end());
+
+    TRY(set.insert(10, 20));
+    TRY(set.insert(30, 40));
+    TEST_EQUAL(set.str(), "10-20,30-40");
+    TRY(set.insert(21, 29));
+    TEST_EQUAL(set.str(), "10-40");
+    TRY(set.insert(5));
+    TRY(set.insert(50, 60));
+    TRY(set.insert(45, 47));
+    TEST_EQUAL(set.str(), "5,10-40,45-47,50-60");
+    TRY(set.insert(0, 100));
+    TEST_EQUAL(set.str(), "0-100");
+    TEST_EQUAL(set.intervals().size(), 1u);
+
+    TEST(! set.contains(-1));
+    TEST(set.contains(0));
+    TEST(set.contains(100));
+    TEST(! set.contains(101));
+
+    TRY(opt = RangeSet<int>::parse("0-4095,8192-16383,100"));
+    TEST(opt);
+    if (opt) {
+        TEST_EQUAL(opt->str(), "0-4095,8192-16383");
+        TEST(opt->contains(4095));
+        TEST(! opt->contains(4096));
+        TEST(opt->contains(8192));
+        TEST(! opt->contains(16384));
+    }
+
+    TRY(opt = RangeSet<int>::parse("-5--1,7,3-4"));
+    TEST(opt);
+    if (opt) {
+        TEST_EQUAL(opt->str(), "-5--1,3-4,7");
+        std::vector<int> v(opt->begin(), opt->end());
+        TEST(v == std::vector<int>({-5, -4, -3, -2, -1, 3, 4, 7}));
+    }
+
+    TRY(opt = RangeSet<int>::parse(""));         TEST(! opt);
+    TRY(opt = RangeSet<int>::parse("1,"));       TEST(! opt);
+    TRY(opt = RangeSet<int>::parse("1-"));       TEST(! opt);
+    TRY(opt = RangeSet<int>::parse("5-1"));      TEST(! opt);
+    TRY(opt = RangeSet<int>::parse("1 - 5"));    TEST(! opt);
+    TRY(opt = RangeSet<int>::parse("abc"));      TEST(! opt);
+
+    RangeSet<uint8_t> small = {{250, 255}, {0, 1}};
+    TEST_EQUAL(small.str(), "0-1,250-255");
+    std::vector<int> v(small.begin(), small.end());
+    TEST(v == std::vector<int>({0, 1, 250, 251, 252, 253, 254, 255}));
+    TEST(! RangeSet<uint8_t>::parse("-1"));
+    TEST(! RangeSet<uint8_t>::parse("0-256"));
+
+}
+
+void test_rs_options_range_set_arguments() {
+
+    RangeSet<int> shards;
+
+    Options opt1("Hello", "", "Says hello.");
+    TRY(opt1.set_colour(false));
+    TRY(opt1.add(shards, "shards", 's', "Shard selection", 0, {}, Constraint<int>::range(0, 65535)));
+
+    {
+        Options opt2 = opt1;
+        TRY(opt2.auto_help());
+        std::ostringstream out;
+        TEST(! opt2.parse({}, out));
+        TEST_EQUAL(out.str(),
+            "\n"
+            "Hello\n"
+            "\n"
+            "Says hello.\n"
+            "\n"
+            "Options:\n"
+            "    --shards, -s <ranges> ...  = Shard selection (0 to 65535)\n"
+            "    --help, -h                 = Show usage information\n"
+            "    --version, -v              = Show version information\n"
+            "\n"
+        );
+    }
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST(opt2.parse({"--shards", "0-4095,8192-16383", "4096-5000", "--shards=60000"}, out));
+        TEST_EQUAL(shards.str(), "0-5000,8192-16383,60000");
+    }
+
+    {
+        shards.clear();
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST_THROW_MATCH(opt2.parse({"--shards", "0-70000"}, out), Options::user_error, "0-70000");
+        TEST_THROW_MATCH(opt1.parse({"--shards", "1-2-3"}, out), Options::user_error, "1-2-3");
+        TEST(shards.empty());
+    }
+
+    RangeSet<int> even;
+    Options opt3("Hello", "", "Says hello.");
+    TRY(opt3.add(even, "even", 'e', "Even option", 0, {}, Constraint<int>::one_of({2, 3, 4, 6})));
+
+    {
+        Options opt4 = opt3;
+        std::ostringstream out;
+        TEST(opt4.parse({"-e", "2-4,6"}, out));
+        TEST_EQUAL(even.str(), "2-4,6");
+        TEST_THROW(opt3.parse({"-e", "4-6"}, out), Options::user_error);
+    }
+
+    RangeSet<int> fast;
+    TEST_THROW_MATCH(opt3.add(fast, "fast", 'f', "Fast option", Options::parallel), Options::setup_error, "range sets");
+
+}
@@ -0,0 +1,180 @@
+#include "rs-options/options.hpp"
+#include "rs-format/format.hpp"
+#include "rs-unit-test.hpp"
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace RS::Format;
+using namespace RS::Option;
+
+namespace {
+
+    // Counts conversions, to show which options were touched
+
+    int conversions = 0;
+
+    struct Counted {
+        std::string text;
+        bool operator==(const Counted& c) const noexcept { return text == c.text; }
+        bool operator!=(const Counted& c) const noexcept { return text != c.text; }
+    };
+
+    std::ostream& operator<<(std::ostream& out, const Counted& c) {
+        return out << c.text;
+    }
+
+}
+
+namespace RS::Option {
+
+    template <>
+    struct OptionTraits<Counted> {
+        static bool parse(std::string_view str, Counted& c) noexcept {
+            ++conversions;
+            c.text = str;
+            return true;
+        }
+    };
+
+}
+
+void test_rs_options_reparse() {
+
+    std::string s = "default";
+    int n = 10;
+    bool b = false;
+    Counted c;
+    std::vector<int> v;
+    std::string_view sv;
+
+    Options opt("Hello", "1.0", "Says hello.");
+    TRY(opt.set_colour(false));
+    TRY(opt.add(s, "string", 's', "String option"));
+    TRY(opt.add(n, "number", 'n', "Number option"));
+    TRY(opt.add(b, "bool", 'b', "Boolean option"));
+    TRY(opt.add(c, "counted", 'c', "Counted option"));
+    TRY(opt.add(v, "vector", 'x', "Vector option", Options::anon));
+    TRY(opt.add(sv, "view", 'w', "View option"));
+
+    std::ostringstream out;
+    std::vector<size_t> changed;
+
+    TEST(opt.parse({"-s", "hello", "-c", "abc", "1", "2", "3"}, out));
+    TEST_EQUAL(s, "hello");
+    TEST_EQUAL(c.text, "abc");
+    TEST_EQUAL(format_range(v), "[1,2,3]");
+    conversions = 0;
+
+    // Only the changed options are converted and set
+
+    TRY(changed = opt.reparse({"-s", "hello", "-c", "abc", "1", "2", "3", "-n", "42"}));
+    TEST_EQUAL(format_range(changed), "[1]");
+    TEST_EQUAL(n, 42);
+    TEST_EQUAL(conversions, 0);
+    TEST(opt.found("number"));
+
+    TRY(changed = opt.reparse({"-n", "42", "-c", "abc", "-s", "hello", "1", "2", "3"}));
+    TEST(changed.empty());
+    TEST_EQUAL(conversions, 0);
+
+    TRY(changed = opt.reparse({"-n", "42", "-c", "xyz", "-s", "hello", "1", "2", "4"}));
+    TEST_EQUAL(format_range(changed), "[3,4]");
+    TEST_EQUAL(c.text, "xyz");
+    TEST_EQUAL(format_range(v), "[1,2,4]");
+    TEST_EQUAL(conversions, 2);  // Checked, then set
+
+    // Options that disappear go back to their original values
+
+    TRY(changed = opt.reparse({"-c", "xyz", "-b"}));
+    TEST_EQUAL(format_range(changed), "[0,1,2,4]");
+    TEST_EQUAL(s, "default");
+    TEST_EQUAL(n, 10);
+    TEST(b);
+    TEST(v.empty());
+    TEST(! opt.found("string"));
+    TEST(opt.found("bool"));
+    TEST_EQUAL(opt.result().value("counted"), "xyz");
+
+    TRY(changed = opt.reparse({"-c", "xyz", "--no-bool", "-w", "view"}));
+    TEST_EQUAL(format_range(changed), "[2,5]");
+    TEST(! b);
+    TEST_EQUAL(sv, "view");
+
+    // A failed reparse changes nothing
+
+    conversions = 0;
+    TEST_THROW_MATCH(opt.reparse({"-c", "new", "-n", "abc"}), Options::user_error, "\"abc\"");
+    TEST_EQUAL(c.text, "xyz");
+    TEST_EQUAL(n, 10);
+    TEST_EQUAL(sv, "view");
+    TEST_EQUAL(opt.result().value("counted"), "xyz");
+    TEST_THROW(opt.reparse({"--nonsense"}), Options::user_error);
+    TEST_THROW(opt.reparse({"-s", "a", "-s", "b"}), Options::user_error);
+    TEST_EQUAL(conversions, 1);  // Checked before the later error was found, never set
+
+    // Without a previous parse, every option found counts as changed
+
+    {
+        std::string s2;
+        int n2 = 0;
+        Options opt2("Hello", "1.0", "Says hello.");
+        TRY(opt2.add(s2, "string", 's', "String option"));
+        TRY(opt2.add(n2, "number", 'n', "Number option"));
+        TRY(changed = opt2.reparse({"-n", "5"}));
+        TEST_EQUAL(format_range(changed), "[1]");
+        TEST_EQUAL(n2, 5);
+    }
+
+    // Options bound to a loaded spec are reset like any others
+
+    {
+        std::vector<int> vals;
+        int x = 5;
+        std::string spec;
+        {
+            Options opt2("Hello", "1.0", "Says hello.");
+            TRY(opt2.add(vals, "vals", 'V', "Value list"));
+            TRY(opt2.add(x, "x", 'x', "X option"));
+            TRY(spec = opt2.save_spec());
+        }
+        Options opt2;
+        TRY(opt2 = Options::load_spec(spec));
+        TRY(opt2.bind(vals, "vals"));
+        TRY(opt2.bind(x, "x"));
+        std::ostringstream out;
+        TEST(opt2.parse({"--vals", "1", "2", "-x", "7"}, out));
+        TEST(vals == std::vector<int>({1, 2}));
+        TEST_EQUAL(x, 7);
+        TRY(changed = opt2.reparse({"--vals", "3"}));
+        TEST_EQUAL(format_range(changed), "[0,1]");
+        TEST(vals == std::vector<int>({3}));
+        TEST_EQUAL(x, 5);
+        TEST(! opt2.found("x"));
+    }
+
+    // A Bounded variable is compared on the values it kept
+
+    {
+        Bounded<int> kept(2);
+        Options opt2("Hello", "1.0", "Says hello.");
+        TRY(opt2.add(kept, "kept", 'k', "Kept values"));
+        std::ostringstream out;
+        TEST(opt2.parse({"-k", "1", "2", "3"}, out));
+        TEST_EQUAL(format_range(kept), "[2,3]");
+        TRY(changed = opt2.reparse({"-k", "1", "2", "3"}));
+        TEST(changed.empty());
+        TRY(changed = opt2.reparse({"-k", "0", "2", "3"}));
+        TEST(changed.empty());
+        TRY(changed = opt2.reparse({"-k", "2", "3"}));
+        TEST_EQUAL(format_range(changed), "[0]");
+        TEST_EQUAL(kept.dropped(), 0u);
+        TRY(changed = opt2.reparse({"-k", "2", "4"}));
+        TEST_EQUAL(format_range(changed), "[0]");
+        TEST_EQUAL(format_range(kept), "[2,4]");
+    }
+
+}
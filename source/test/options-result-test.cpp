@@ -0,0 +1,99 @@
+#include "rs-options/options.hpp"
+#include "rs-unit-test.hpp"
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace RS::Option;
+
+void test_rs_options_result() {
+
+    bool flag = false;
+    int count = 0;
+    std::string name;
+    std::vector<double> values;
+
+    Options opt1("Hello", "", "Says hello.");
+    TRY(opt1.set_colour(false));
+    TRY(opt1.add(flag, "flag", 'f', "Flag option"));
+    TRY(opt1.add(count, "count", 'c', "Count option"));
+    TRY(opt1.add(name, "name", 'n', "Name option"));
+    TRY(opt1.add(values, "values", 'x', "Value list", Options::anon));
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST(opt2.parse({"1.5", "-c", "42", "2.5", "--no-flag", "--values=3.5", "-x", "4.5"}, out));
+        auto& r = opt2.result();
+
+        TEST_EQUAL(r.size(), 6u);
+        TEST_EQUAL(r.index("flag"), 0u);
+        TEST_EQUAL(r.index("--values"), 3u);
+        TEST_EQUAL(r.index("version"), 5u);
+        TEST_EQUAL(r.index("nothing"), std::string::npos);
+        TEST_EQUAL(r.name(2), "name");
+
+        TEST(r.found("flag"));
+        TEST(r.found("count"));
+        TEST(! r.found("name"));
+        TEST(r.found("values"));
+        TEST(! r.found("help"));
+        TEST(! r.found("nothing"));
+
+        TEST_EQUAL(r.count("flag"), 1u);
+        TEST_EQUAL(r.count("count"), 1u);
+        TEST_EQUAL(r.count("name"), 0u);
+        TEST_EQUAL(r.count("values"), 4u);
+
+        TEST_EQUAL(r.values("flag"), 1u);
+        TEST_EQUAL(r.values("count"), 1u);
+        TEST_EQUAL(r.values("name"), 0u);
+        TEST_EQUAL(r.values("values"), 4u);
+
+        TEST_EQUAL(r.value("count"), "42");
+        TEST_EQUAL(r.value("values", 0), "1.5");
+        TEST_EQUAL(r.value("values", 1), "2.5");
+        TEST_EQUAL(r.value("values", 2), "3.5");
+        TEST_EQUAL(r.value("values", 3), "4.5");
+        TEST_EQUAL(r.value("values", 4), "");
+        TEST_EQUAL(r.value("name"), "");
+
+        TEST_EQUAL(r.value("flag"), "f");
+        TEST(r.get<bool>("flag") == false);
+        TEST(r.get<int>("count") == 42);
+        TEST(r.get<double>("values", 3) == 4.5);
+        TEST(r.get<std::string>("count") == "42");
+        TEST(! r.get<int>("name"));
+        TEST(! r.get<int>("values"));
+
+        TEST(! flag);
+        TEST_EQUAL(count, 42);
+        TEST_EQUAL(values.size(), 4u);
+    }
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST_THROW(opt2.parse({"-c", "abc"}, out), Options::user_error);
+        TEST_EQUAL(opt2.result().size(), 0u);
+    }
+
+    {
+        // A failed parse discards the result of an earlier one, even if
+        // that result was never built
+
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST(opt2.parse({"-c", "7", "--name=alice"}, out));
+        Options opt3 = opt2;
+        TEST_THROW(opt2.parse({"-c", "abc"}, out), Options::user_error);
+        TEST_EQUAL(opt2.result().size(), 0u);
+        const Options& copy = opt3;
+        TEST_EQUAL(copy.result().value("count"), "7");
+        TEST_EQUAL(copy.result().value("name"), "alice");
+        TEST_EQUAL(&copy.result(), &opt3.result());
+    }
+
+}
@@ -0,0 +1,79 @@
+// Code size probe for Options::add(). This is built twice, once binding a
+// single argument type and once binding many distinct types, and the
+// difference in text size gives the cost of each additional type. See
+// size-check.cmake for the regression check.
+
+#include "rs-options/options.hpp"
+#include "rs-tl/enum.hpp"
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+
+#ifndef RS_OPTIONS_SIZE_TYPES
+    #define RS_OPTIONS_SIZE_TYPES 1
+#endif
+
+using namespace RS::Option;
+
+RS_DEFINE_ENUM_CLASS(Enum1, int, 0, alpha, bravo, charlie)
+RS_DEFINE_ENUM_CLASS(Enum2, int, 0, delta, echo, foxtrot)
+RS_DEFINE_ENUM_CLASS(Enum3, int, 0, golf, hotel, india)
+RS_DEFINE_ENUM_CLASS(Enum4, int, 0, juliet, kilo, lima)
+
+int main(int argc, char** argv) {
+
+    Options opt("size-check", "", "Code size probe.");
+
+    int v1 = 0;
+    opt.add(v1, "int", '\0', "Option of type int");
+
+    #if RS_OPTIONS_SIZE_TYPES > 1
+
+        int8_t v2{};
+        int16_t v3{};
+        int64_t v4{};
+        uint8_t v5{};
+        uint16_t v6{};
+        uint32_t v7{};
+        uint64_t v8{};
+        float v9{};
+        double v10{};
+        std::string v11{};
+        Enum1 v12{};
+        Enum2 v13{};
+        Enum3 v14{};
+        Enum4 v15{};
+        std::vector<int> v16{};
+        std::vector<double> v17{};
+        std::vector<std::string> v18{};
+        std::vector<Enum1> v19{};
+        std::set<Enum2> v20{};
+
+        opt.add(v2, "int8", '\0', "Option of type int8");
+        opt.add(v3, "int16", '\0', "Option of type int16");
+        opt.add(v4, "int64", '\0', "Option of type int64");
+        opt.add(v5, "uint8", '\0', "Option of type uint8");
+        opt.add(v6, "uint16", '\0', "Option of type uint16");
+        opt.add(v7, "uint32", '\0', "Option of type uint32");
+        opt.add(v8, "uint64", '\0', "Option of type uint64");
+        opt.add(v9, "float", '\0', "Option of type float");
+        opt.add(v10, "double", '\0', "Option of type double");
+        opt.add(v11, "string", '\0', "Option of type string");
+        opt.add(v12, "enum1", '\0', "Option of type enum1");
+        opt.add(v13, "enum2", '\0', "Option of type enum2");
+        opt.add(v14, "enum3", '\0', "Option of type enum3");
+        opt.add(v15, "enum4", '\0', "Option of type enum4");
+        opt.add(v16, "int-vector", '\0', "Option of type int-vector");
+        opt.add(v17, "double-vector", '\0', "Option of type double-vector");
+        opt.add(v18, "string-vector", '\0', "Option of type string-vector");
+        opt.add(v19, "enum1-vector", '\0', "Option of type enum1-vector");
+        opt.add(v20, "enum2-set", '\0', "Option of type enum2-set");
+
+        static_assert(RS_OPTIONS_SIZE_TYPES == 20);
+
+    #endif
+
+    return opt.parse(argc, argv) ? 0 : 1;
+
+}
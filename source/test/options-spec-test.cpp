@@ -0,0 +1,159 @@
+#include "rs-options/options.hpp"
+#include "rs-tl/enum.hpp"
+#include "rs-unit-test.hpp"
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace RS::Option;
+
+namespace {
+
+    RS_DEFINE_ENUM_CLASS(Speed, int, 1, slow, medium, fast)
+
+}
+
+void test_rs_options_spec() {
+
+    std::string spec;
+
+    {
+        bool flag = false;
+        int count = 10;
+        std::string name = "Nobody";
+        Speed speed = Speed::medium;
+        std::vector<std::string> files;
+
+        Options opt1("Hello", "1.0", "Says hello.");
+        TRY(opt1.set_colour(false));
+        TRY(opt1.allow_prefix());
+        TRY(opt1.add(flag, "flag", 'f', "Flag option"));
+        TRY(opt1.add(count, "count", 'c', "Count option", 0, {}, Constraint<int>::range(1, 100)));
+        TRY(opt1.add(name, "name", 'n', "Name option", 0, "group", "[A-Z][a-z]+"));
+        TRY(opt1.add(speed, "speed", 's', "Speed option", 0, "group"));
+        TRY(opt1.add(files, "files", 0, "File list", Options::anon));
+        TRY(spec = opt1.save_spec());
+    }
+
+    TEST_MATCH(spec, "^RSOPTSPC");
+
+    bool flag = false;
+    int count = 10;
+    std::string name = "Nobody";
+    Speed speed = Speed::medium;
+    std::vector<std::string> files;
+
+    Options opt1;
+    TRY(opt1 = Options::load_spec(spec));
+    TEST_EQUAL(opt1.save_spec(), spec);
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST_THROW_MATCH(opt2.parse({"--flag"}, out), Options::setup_error, "No variable was bound");
+    }
+
+    TEST_THROW_MATCH(opt1.bind(count, "nothing"), Options::setup_error, "Unknown option");
+    TEST_THROW_MATCH(opt1.bind(name, "count"), Options::setup_error, "Variable type does not match");
+    TRY(opt1.bind(flag, "flag"));
+    TRY(opt1.bind(count, "count", Constraint<int>::range(1, 100)));
+    TRY(opt1.bind(name, "--name"));
+    TRY(opt1.bind(speed, "speed"));
+    TRY(opt1.bind(files, "files"));
+    TEST_THROW_MATCH(opt1.bind(flag, "flag"), Options::setup_error, "already bound");
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST(! opt2.parse({"--help"}, out));
+        TEST_EQUAL(out.str(),
+            "\n"
+            "Hello 1.0\n"
+            "\n"
+            "Says hello.\n"
+            "\n"
+            "Options:\n"
+            "    --flag, -f           = Flag option\n"
+            "    --count, -c <int>    = Count option (1 to 100; default 10)\n"
+            "    --name, -n <arg>     = Name option (default \"Nobody\")\n"
+            "    --speed, -s <arg>    = Speed option (default medium)\n"
+            "    [--files] <arg> ...  = File list\n"
+            "    --help, -h           = Show usage information\n"
+            "    --version, -v        = Show version information\n"
+            "\n"
+        );
+    }
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST(opt2.parse({"--fl", "--cou", "42", "-s", "fast", "a", "b"}, out));
+        TEST(flag);
+        TEST_EQUAL(count, 42);
+        TEST(speed == Speed::fast);
+        TEST(files == std::vector<std::string>({"a", "b"}));
+        TEST(opt2.found("count"));
+        TEST(! opt2.found("name"));
+    }
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST_THROW_MATCH(opt2.parse({"-c", "999"}, out), Options::user_error, "999");
+        TEST_THROW_MATCH(opt1.parse({"-n", "alice"}, out), Options::user_error, "alice");
+        TEST_THROW_MATCH(opt1.parse({"-n", "Alice", "-s", "slow"}, out), Options::user_error, "--name.+--speed");
+    }
+
+    {
+        // A saved pattern is compiled on first use, including from a
+        // parallel batch
+
+        std::vector<std::string> words;
+        Options opt2("Hello", "", "Says hello.");
+        TRY(opt2.add(words, "words", 'w', "Word list", Options::parallel, "", "[a-z]+"));
+        Options opt3;
+        TRY(opt3 = Options::load_spec(opt2.save_spec()));
+        TRY(opt3.bind(words, "words"));
+        std::vector<std::string> args = {"--words"};
+        for (int i = 0; i < 10'000; ++i)
+            args.push_back(std::string(size_t(i % 7 + 1), char('a' + i % 26)));
+        Options opt4 = opt3;
+        std::ostringstream out;
+        TEST(opt4.parse(args, out));
+        TEST_EQUAL(words.size(), 10'000u);
+        words.clear();
+        args[9'000] = "ABC";
+        TEST_THROW_MATCH(opt3.parse(args, out), Options::user_error, "ABC");
+        TEST(words.empty());
+    }
+
+    {
+        // Options added to a loaded spec are indexed before the next parse
+
+        Options opt2;
+        TRY(opt2 = Options::load_spec(spec));
+        TRY(opt2.bind(flag, "flag"));
+        TRY(opt2.bind(count, "count", Constraint<int>::range(1, 100)));
+        TRY(opt2.bind(name, "name"));
+        TRY(opt2.bind(speed, "speed"));
+        std::vector<std::string> files2;
+        TRY(opt2.bind(files2, "files"));
+        std::vector<int> extra(100, 0);
+        for (size_t i = 0; i < extra.size(); ++i)
+            TRY(opt2.add(extra[i], "extra-" + std::to_string(i), '\0', "Extra option"));
+        std::ostringstream out;
+        TEST(opt2.parse({"--extra-42", "7", "--extra-99=8", "--fl"}, out));
+        TEST_EQUAL(extra[42], 7);
+        TEST_EQUAL(extra[99], 8);
+        TEST(flag);
+        TEST(opt2.found("extra-42"));
+        TEST_THROW_MATCH(opt2.parse({"--extr", "1"}, out), Options::user_error, "Ambiguous");
+    }
+
+    TEST_THROW_MATCH(Options::load_spec("hello"), Options::setup_error, "Not an option spec");
+    TEST_THROW_MATCH(Options::load_spec(spec.substr(0, spec.size() - 1)), Options::setup_error, "truncated");
+    TEST_THROW_MATCH(Options::load_spec(spec + "x"), Options::setup_error, "corrupt");
+
+}
@@ -0,0 +1,100 @@
+#include "rs-options/options.hpp"
+#include "rs-unit-test.hpp"
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace RS::Option;
+
+void test_rs_options_status() {
+
+    using code = Options::error_code;
+
+    std::string s;
+    int i = 0;
+    unsigned char u = 0;
+    bool b = false;
+    std::vector<int> v;
+
+    Options opt1("Hello", "", "Says hello.");
+    TRY(opt1.set_colour(false));
+    TRY(opt1.add(s, "string", 's', "String option", Options::required));
+    TRY(opt1.add(i, "integer", 'i', "Integer option", 0, "group"));
+    TRY(opt1.add(u, "unsigned", 'u', "Unsigned option", 0, "group"));
+    TRY(opt1.add(b, "boolean", 'b', "Boolean option"));
+    TRY(opt1.add(v, "vector", 'x', "Vector option"));
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        Options::parse_status status(false);
+        TRY(status = opt2.try_parse({"--string", "hello", "--integer", "42", "--boolean=no", "-x", "1", "2"}, out));
+        TEST(status);
+        TEST(status.has_value());
+        TEST(*status);
+        TEST(status.value());
+        TEST_EQUAL(int(status.error().code), int(code::none));
+        TEST_EQUAL(s, "hello");
+        TEST_EQUAL(i, 42);
+        TEST(! b);
+        TEST_EQUAL(v.size(), 2u);
+    }
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        Options::parse_status status(false);
+        TRY(status = opt2.try_parse({"--help"}, out));
+        TEST(status);
+        TEST(! *status);
+        TEST(! out.str().empty());
+    }
+
+    struct test_case {
+        std::vector<std::string> args;
+        code expect_code;
+        size_t expect_index;
+        std::string expect_option;
+        std::string expect_argument;
+        std::string expect_message;
+    };
+
+    std::vector<test_case> cases = {
+        { {"-s", "x", "--foo"},                code::unknown_option,       2,     "",          "--foo",    R"(^Unknown option: "--foo"$)" },
+        { {"-s", "x", "-bq"},                  code::unknown_option,       2,     "",          "-q",       R"(^Unknown option: "-q"$)" },
+        { {"-s", "x", "--integer", "abc"},     code::pattern_mismatch,     3,     "integer",   "abc",      R"(^Argument does not match expected pattern: "abc"$)" },
+        { {"-s", "x", "--unsigned", "256"},    code::invalid_argument,     3,     "unsigned",  "256",      R"(^Invalid argument to --unsigned: "256"$)" },
+        { {"-s", "x", "--boolean=maybe"},      code::invalid_argument,     2,     "boolean",   "maybe",    R"(^Invalid argument to --boolean: "maybe"$)" },
+        { {"-s", "x", "-i", "1", "-u", "2"},   code::mutually_exclusive,   4,     "unsigned",  "",         R"(^Options --integer, --unsigned are mutually exclusive$)" },
+        { {"-s", "x", "-s", "y"},              code::repeated_option,      2,     "string",    "",         R"(^Repeated option: --string$)" },
+        { {"-s", "x", "y"},                    code::unassigned_argument,  2,     "",          "y",        R"(^Argument not associated with an option: "y"$)" },
+        { {"-s", "x", "--=x"},                 code::invalid_option,       2,     "",          "--=x",     R"(^Invalid option: "--=x"$)" },
+        { {"-i", "1"},                         code::required_missing,     std::string::npos,  "string",    "",         R"(^Required option not found: --string$)" },
+    };
+
+    for (auto& c: cases) {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        Options::parse_status status(false);
+        TRY(status = opt2.try_parse(c.args, out));
+        TEST(! status);
+        TEST(! status.has_value());
+        TEST(! *status);
+        auto& error = status.error();
+        TEST(bool(error));
+        TEST_EQUAL(int(error.code), int(c.expect_code));
+        TEST_EQUAL(error.index, c.expect_index);
+        TEST_EQUAL(error.option, c.expect_option);
+        TEST_EQUAL(error.argument, c.expect_argument);
+        TEST_MATCH(opt2.error_message(error), c.expect_message);
+    }
+
+    for (auto& c: cases) {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST_THROW_MATCH(opt2.parse(c.args, out), Options::user_error, c.expect_message);
+    }
+
+}
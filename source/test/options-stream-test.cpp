@@ -0,0 +1,165 @@
+#include "rs-options/options.hpp"
+#include "rs-format/format.hpp"
+#include "rs-unit-test.hpp"
+#include <cstdio>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef _WIN32
+    #define RS_FILENO _fileno
+#else
+    #define RS_FILENO fileno
+#endif
+
+using namespace RS::Format;
+using namespace RS::Option;
+
+namespace {
+
+    // Temporary file positioned at the start of its content
+
+    struct TempInput {
+        std::unique_ptr<std::FILE, int (*)(std::FILE*)> file;
+        explicit TempInput(std::string_view content): file(std::tmpfile(), &std::fclose) {
+            std::fwrite(content.data(), 1, content.size(), file.get());
+            std::rewind(file.get());
+        }
+        int fd() const { return RS_FILENO(file.get()); }
+    };
+
+}
+
+void test_rs_options_stream() {
+
+    using code = Options::error_code;
+
+    std::string s;
+    bool b = false;
+    int n = 0;
+    std::vector<std::string> v;
+    std::vector<int> w;
+
+    Options opt1("Hello", "1.0", "Says hello.");
+    TRY(opt1.set_colour(false));
+    TRY(opt1.add(s, "string", 's', "String option"));
+    TRY(opt1.add(b, "bool", 'b', "Boolean option"));
+    TRY(opt1.add(n, "number", 'n', "Number option"));
+    TRY(opt1.add(v, "file", 'f', "File option", Options::anon));
+    TRY(opt1.add(w, "int", 'i', "Integer option", Options::required));
+
+    {
+        Options opt2 = opt1;
+        TEST_THROW(opt2.stream_args("nonsense"), Options::setup_error);
+        TEST_THROW(opt2.stream_args("bool"), Options::setup_error);
+        TEST_THROW(opt2.stream_args("string"), Options::setup_error);
+        TRY(opt2.stream_args("string", 0, '\n', [] (std::string_view) {}));
+    }
+
+    {
+        TempInput in(std::string("alpha\0bravo\0\0charlie\0delta", 27));
+        Options opt2 = opt1;
+        TRY(opt2.stream_args("file", in.fd()));
+        std::ostringstream out;
+        TEST(opt2.parse({"first", "-s", "hello", "-i", "42"}, out));
+        TEST_EQUAL(s, "hello");
+        TEST_EQUAL(v.size(), 5u);
+        TEST_EQUAL(format_range(v), "[first,alpha,bravo,charlie,delta]");
+        TEST(opt2.found("file"));
+        v.clear();
+        w.clear();
+    }
+
+    // A required option can be satisfied by the stream alone
+
+    {
+        TempInput in("1\n2\n3\n");
+        Options opt2 = opt1;
+        TRY(opt2.stream_args("int", in.fd(), '\n'));
+        std::ostringstream out;
+        TEST(opt2.parse({"-b"}, out));
+        TEST(b);
+        TEST_EQUAL(format_range(w), "[1,2,3]");
+        b = false;
+        w.clear();
+    }
+
+    {
+        TempInput in("");
+        Options opt2 = opt1;
+        TRY(opt2.stream_args("int", in.fd(), '\n'));
+        std::ostringstream out;
+        Options::parse_status status(false);
+        TRY(status = opt2.try_parse({"-b"}, out));
+        TEST(! status);
+        TEST_EQUAL(int(status.error().code), int(code::required_missing));
+        TEST_EQUAL(status.error().option, "int");
+        b = false;
+    }
+
+    // Errors are indexed after the command line arguments
+
+    {
+        TempInput in("1\n2\nthree\n4\n");
+        Options opt2 = opt1;
+        TRY(opt2.stream_args("int", in.fd(), '\n'));
+        std::ostringstream out;
+        Options::parse_status status(false);
+        TRY(status = opt2.try_parse({"-s", "x"}, out));
+        TEST(! status);
+        TEST_EQUAL(int(status.error().code), int(code::pattern_mismatch));
+        TEST_EQUAL(status.error().index, 4u);
+        TEST_EQUAL(status.error().argument, "three");
+        w.clear();
+    }
+
+    // With a callback, values are checked but not stored
+
+    {
+        std::string big(Options::stream_buffer_size + 100, 'x');
+        std::string content;
+        for (int i = 0; i < 10000; ++i)
+            content += std::to_string(i) + '\0';
+        content += big;
+        content += '\0';
+        TempInput in(content);
+        Options opt2 = opt1;
+        size_t count = 0;
+        size_t bytes = 0;
+        TRY(opt2.stream_args("file", in.fd(), '\0', [&] (std::string_view value) { ++count; bytes += value.size(); }));
+        std::ostringstream out;
+        TEST(opt2.parse({"-i", "1"}, out));
+        TEST(v.empty());
+        TEST_EQUAL(count, 10001u);
+        TEST_EQUAL(bytes, content.size() - 10001);
+        w.clear();
+    }
+
+    {
+        TempInput in("1\n2\n3\n");
+        Options opt2 = opt1;
+        int sum = 0;
+        TRY(opt2.stream_args("number", in.fd(), '\n', [&sum] (std::string_view value) { sum += std::stoi(std::string(value)); }));
+        std::ostringstream out;
+        TEST(opt2.parse({"-i", "1"}, out));
+        TEST_EQUAL(sum, 6);
+        TEST_EQUAL(n, 0);
+        w.clear();
+    }
+
+    // The stream is not read for help or version requests
+
+    {
+        TempInput in("1\n2\n3\n");
+        Options opt2 = opt1;
+        TRY(opt2.stream_args("int", in.fd(), '\n'));
+        std::ostringstream out;
+        TEST(! opt2.parse({"--version", "-b"}, out));
+        TEST_EQUAL(out.str(), "Hello 1.0\n");
+        TEST(w.empty());
+        b = false;
+    }
+
+}
@@ -0,0 +1,117 @@
+#include "rs-options/options.hpp"
+#include "rs-unit-test.hpp"
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace RS::Option;
+
+void test_rs_options_string_view() {
+
+    std::string_view name = "Nobody";
+    std::string_view mode;
+    std::vector<std::string_view> paths;
+
+    Options opt1("Hello", "", "Says hello.");
+    TRY(opt1.set_colour(false));
+    TRY(opt1.add(name, "name", 'n', "Name option", 0, "", "[A-Z][a-z]+"));
+    TRY(opt1.add(mode, "mode", 'm', "Mode option", 0, {}, Constraint<std::string_view>::one_of({"fast", "slow"})));
+    TRY(opt1.add(paths, "paths", 'p', "Path list", Options::anon));
+
+    {
+        Options opt2 = opt1;
+        TRY(opt2.auto_help());
+        std::ostringstream out;
+        TEST(! opt2.parse({}, out));
+        TEST_EQUAL(out.str(),
+            "\n"
+            "Hello\n"
+            "\n"
+            "Says hello.\n"
+            "\n"
+            "Options:\n"
+            "    --name, -n <arg>         = Name option (default \"Nobody\")\n"
+            "    --mode, -m <arg>         = Mode option (one of fast, slow)\n"
+            "    [--paths, -p] <arg> ...  = Path list\n"
+            "    --help, -h               = Show usage information\n"
+            "    --version, -v            = Show version information\n"
+            "\n"
+        );
+    }
+
+    {
+        char arg0[] = "hello";
+        char arg1[] = "--name=Alice";
+        char arg2[] = "-m";
+        char arg3[] = "slow";
+        char arg4[] = "foo.txt";
+        char arg5[] = "bar.txt";
+        char* argv[] = {arg0, arg1, arg2, arg3, arg4, arg5, nullptr};
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST(opt2.parse(6, argv, out));
+        TEST_EQUAL(name, "Alice");
+        TEST_EQUAL(mode, "slow");
+        TEST_EQUAL(paths.size(), 2u);
+        TEST(name.data() == arg1 + 7);
+        TEST(mode.data() == arg3);
+        if (paths.size() == 2) {
+            TEST(paths[0].data() == arg4);
+            TEST(paths[1].data() == arg5);
+        }
+    }
+
+    {
+        paths.clear();
+        Options opt2 = opt1;
+        std::ostringstream out;
+        {
+            std::vector<std::string> args = {"-n", "Bob", "--mode=fast", "a-long-path-name/not-short-string-optimised.txt"};
+            TEST(opt2.parse(args, out));
+        }
+        TEST_EQUAL(name, "Bob");
+        TEST_EQUAL(mode, "fast");
+        TEST_EQUAL(paths.size(), 1u);
+        if (! paths.empty())
+            TEST_EQUAL(paths[0], "a-long-path-name/not-short-string-optimised.txt");
+    }
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST_THROW_MATCH(opt2.parse({"-n", "carol"}, out), Options::user_error, "carol");
+        TEST_THROW_MATCH(opt1.parse({"-m", "medium"}, out), Options::user_error, "medium");
+    }
+
+    // A view stays valid until its option is set again, and each new value
+    // replaces the old copy instead of adding to it
+
+    {
+        paths.clear();
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST(opt2.parse({"-n", "Bob", "a-long-path-name/not-short-string-optimised.txt"}, out));
+        TEST(opt2.parse({"-m", "slow"}, out));
+        TEST_EQUAL(name, "Bob");
+        TEST_EQUAL(paths.size(), 1u);
+        if (! paths.empty())
+            TEST_EQUAL(paths[0], "a-long-path-name/not-short-string-optimised.txt");
+        for (int i = 0; i < 1000; ++i) {
+            std::string long_name = "Averyveryverylongnamethatisnotshortstringoptimised" + std::string(size_t(i % 10), 'x');
+            TRY(opt2.reparse({"-n", long_name, "-m", "fast"}));
+            TEST_EQUAL(name, long_name);
+        }
+        TEST_EQUAL(mode, "fast");
+        TEST_EQUAL(paths.size(), 1u);
+        if (! paths.empty())
+            TEST_EQUAL(paths[0], "a-long-path-name/not-short-string-optimised.txt");
+    }
+
+    std::string_view bad = "nobody";
+    Options opt3("Hello", "", "Says hello.");
+    TEST_THROW(opt3.add(bad, "bad", 'b', "Bad option", 0, "", "[A-Z][a-z]+"), Options::setup_error);
+
+}
@@ -0,0 +1,88 @@
+#include "rs-options/options.hpp"
+#include "rs-tl/enum.hpp"
+#include "rs-unit-test.hpp"
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace RS::Option;
+
+RS_DEFINE_ENUM_CLASS(Colour, int, 1, red, green, blue)
+
+void test_rs_options_suggestion() {
+
+    bool verbose = false;
+    int count = 0;
+    Colour colour = Colour::red;
+    std::vector<Colour> palette;
+
+    Options opt1("Hello", "", "Says hello.");
+    TRY(opt1.set_colour(false));
+    TRY(opt1.add(verbose, "verbose", 0, "Verbose option"));
+    TRY(opt1.add(count, "count", 0, "Count option"));
+    TRY(opt1.add(colour, "colour", 0, "Colour option"));
+    TRY(opt1.add(palette, "palette", 0, "Palette option"));
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST_THROW_MATCH(opt2.parse({"--verbos"}, out), Options::user_error,
+            R"(Unknown option: "--verbos" \(did you mean "--verbose"\?\))");
+    }
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST_THROW_MATCH(opt2.parse({"--no-verbsoe"}, out), Options::user_error,
+            R"(did you mean "--no-verbose"\?)");
+    }
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST_THROW_MATCH(opt2.parse({"--cuont", "42"}, out), Options::user_error,
+            R"(did you mean "--count"\?)");
+    }
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST_THROW_MATCH(opt2.parse({"--xyzzy"}, out), Options::user_error,
+            R"(^Unknown option: "--xyzzy"$)");
+    }
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST_THROW_MATCH(opt2.parse({"--colour", "gren"}, out), Options::user_error,
+            R"("gren" \(did you mean "green"\?\))");
+    }
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST_THROW_MATCH(opt2.parse({"--palette", "red", "bleu"}, out), Options::user_error,
+            R"("bleu" \(did you mean "blue"\?\))");
+    }
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST_THROW_MATCH(opt2.parse({"--colour", "purple"}, out), Options::user_error,
+            R"("purple"$)");
+    }
+
+    {
+        // Large specs should still produce the closest name
+        std::vector<int> values(5000);
+        Options opt2("Hello", "", "Says hello.");
+        for (size_t i = 0; i < values.size(); ++i)
+            TRY(opt2.add(values[i], "option-number-" + std::to_string(i), 0, "Numbered option"));
+        std::ostringstream out;
+        TEST_THROW_MATCH(opt2.parse({"--option-numbr-4321"}, out), Options::user_error,
+            R"(did you mean "--option-number-4321"\?)");
+    }
+
+}
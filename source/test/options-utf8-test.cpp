@@ -0,0 +1,93 @@
+#include "rs-options/options.hpp"
+#include "rs-unit-test.hpp"
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace RS::Option;
+
+void test_rs_options_utf8() {
+
+    using code = Options::error_code;
+
+    std::string s;
+    std::string t;
+    std::vector<std::string> v;
+
+    Options opt1("Hello", "", "Says hello.");
+    TRY(opt1.set_colour(false));
+    TRY(opt1.add(s, "string", 's', "String option", Options::utf8));
+    TRY(opt1.add(t, "text", 't', "Text option"));
+    TRY(opt1.add(v, "vector", 'v', "Vector option", Options::anon | Options::utf8));
+
+    {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        TEST(opt2.parse({"-s", "h\xc3\xa9llo", "-t", "\xff", "\xe2\x82\xac", "\xf0\x9f\x98\x80"}, out));
+        TEST_EQUAL(s, "h\xc3\xa9llo");
+        TEST_EQUAL(t, "\xff");
+        TEST_EQUAL(v.size(), 2u);
+        v.clear();
+    }
+
+    struct test_case {
+        std::vector<std::string> args;
+        size_t expect_index;
+        std::string expect_option;
+        std::string expect_message;
+    };
+
+    std::vector<test_case> cases = {
+        { {"-s", "ab\xff"},                                             1,  "string",  "at byte 2" },
+        { {"-s", "\xc0\xaf"},                                           1,  "string",  "at byte 0" },  // Overlong
+        { {"-s", "x\xed\xa0\x80"},                                      1,  "string",  "at byte 1" },  // Surrogate
+        { {"-s", "xy\xf4\x90\x80\x80"},                                 1,  "string",  "at byte 2" },  // Past U+10FFFF
+        { {"-s", "abc\xe2\x82"},                                        1,  "string",  "at byte 3" },  // Truncated
+        { {"-s", "\xe2\x82\xac\x80"},                                   1,  "string",  "at byte 3" },  // Stray continuation
+        { {"--string=abcd\xff"},                                        0,  "string",  "at byte 4" },
+        { {"-s", "abcdefghijklmnopqrstuvwxyz0123456789ABCD\xfe"},       1,  "string",  "at byte 40" },
+        { {"-s", "x", "hello", "\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3"},  3,  "vector",  "at byte 8" },
+    };
+
+    for (auto& c: cases) {
+        Options opt2 = opt1;
+        std::ostringstream out;
+        Options::parse_status status(false);
+        TRY(status = opt2.try_parse(c.args, out));
+        TEST(! status);
+        TEST_EQUAL(int(status.error().code), int(code::invalid_encoding));
+        TEST_EQUAL(status.error().index, c.expect_index);
+        TEST_EQUAL(status.error().option, c.expect_option);
+        TEST_MATCH(opt2.error_message(status.error()), "^Invalid UTF-8 in argument to --" + c.expect_option + " " + c.expect_message + ": ");
+    }
+
+    {
+        Options opt2 = opt1;
+        std::vector<Options::parse_error> errors;
+        TRY(errors = opt2.check({"-s", "\xff", "-t", "\xff", "\xff"}));
+        TEST_EQUAL(errors.size(), 2u);
+        TEST_EQUAL(errors[0].option, "string");
+        TEST_EQUAL(errors[1].option, "vector");
+    }
+
+    // The global setting applies to every option
+
+    {
+        Options opt2 = opt1;
+        TRY(opt2.check_utf8());
+        std::ostringstream out;
+        TEST_THROW_MATCH(opt2.parse({"-t", "ab\xff"}, out), Options::user_error,
+            "^Invalid UTF-8 in argument to --text at byte 2: ");
+        std::string spec;
+        TRY(spec = opt2.save_spec());
+        TRY(opt2 = Options::load_spec(spec));
+        TRY(opt2.bind(s, "string"));
+        TRY(opt2.bind(t, "text"));
+        v.clear();
+        TRY(opt2.bind(v, "vector"));
+        TEST_THROW_MATCH(opt2.parse({"-t", "ab\xff"}, out), Options::user_error,
+            "^Invalid UTF-8 in argument to --text at byte 2: ");
+    }
+
+}
@@ -0,0 +1,27 @@
+# Code size regression check for Options::add(), run by ctest. The two
+# probe programs are built from options-size-check.cpp, binding one and
+# many argument types; the difference in text size, divided by the
+# number of extra types, must not exceed the budget.
+#
+# cmake -D SIZE_PROGRAM=<size> -D BASE=<probe> -D FULL=<probe> -D TYPES=<n> -D BUDGET=<bytes> -P size-check.cmake
+
+function(text_size file result)
+    execute_process(COMMAND ${SIZE_PROGRAM} ${file} OUTPUT_VARIABLE output RESULT_VARIABLE status)
+    if(NOT status EQUAL 0)
+        message(FATAL_ERROR "Unable to read code size: ${file}")
+    endif()
+    string(REGEX MATCH "\n[ \t]*([0-9]+)" match "${output}")
+    if(NOT match)
+        message(FATAL_ERROR "Unexpected output from ${SIZE_PROGRAM}:\n${output}")
+    endif()
+    set(${result} ${CMAKE_MATCH_1} PARENT_SCOPE)
+endfunction()
+
+text_size(${BASE} base_size)
+text_size(${FULL} full_size)
+math(EXPR per_type "(${full_size} - ${base_size}) / (${TYPES} - 1)")
+message(STATUS "Text size: ${base_size} bytes for 1 type, ${full_size} bytes for ${TYPES} types, ${per_type} bytes per type")
+
+if(per_type GREATER BUDGET)
+    message(FATAL_ERROR "Text size per argument type is ${per_type} bytes, budget is ${BUDGET} bytes")
+endif()
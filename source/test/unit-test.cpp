@@ -39,6 +39,75 @@ int main(int argc, char** argv) {
     // options-mutual-exclusion-test.cpp
     UNIT_TEST(rs_options_mutual_exclusion)
 
+    // options-prefix-test.cpp
+    UNIT_TEST(rs_options_prefix)
+
+    // options-suggestion-test.cpp
+    UNIT_TEST(rs_options_suggestion)
+
+    // options-completion-test.cpp
+    UNIT_TEST(rs_options_completion)
+
+    // options-status-test.cpp
+    UNIT_TEST(rs_options_status)
+
+    // options-check-test.cpp
+    UNIT_TEST(rs_options_check)
+
+    // options-constraint-test.cpp
+    UNIT_TEST(rs_options_constraint)
+
+    // options-parallel-test.cpp
+    UNIT_TEST(rs_options_parallel)
+
+    // options-interned-test.cpp
+    UNIT_TEST(rs_options_interned_strings)
+    UNIT_TEST(rs_options_interned_arguments)
+
+    // options-string-view-test.cpp
+    UNIT_TEST(rs_options_string_view)
+
+    // options-range-set-test.cpp
+    UNIT_TEST(rs_options_range_set_class)
+    UNIT_TEST(rs_options_range_set_arguments)
+
+    // options-lazy-test.cpp
+    UNIT_TEST(rs_options_lazy)
+
+    // options-result-test.cpp
+    UNIT_TEST(rs_options_result)
+
+    // options-option-traits-test.cpp
+    UNIT_TEST(rs_options_option_traits)
+
+    // options-spec-test.cpp
+    UNIT_TEST(rs_options_spec)
+
+    // options-fast-exit-test.cpp
+    UNIT_TEST(rs_options_fast_exit)
+
+    // options-utf8-test.cpp
+    UNIT_TEST(rs_options_utf8)
+
+    // options-events-test.cpp
+    UNIT_TEST(rs_options_events)
+
+    // options-stream-test.cpp
+    UNIT_TEST(rs_options_stream)
+
+    // options-frozen-test.cpp
+    UNIT_TEST(rs_options_frozen)
+
+    // options-reparse-test.cpp
+    UNIT_TEST(rs_options_reparse)
+
+    // options-generated-test.cpp
+    UNIT_TEST(rs_options_generated)
+
+    // options-bounded-test.cpp
+    UNIT_TEST(rs_options_bounded_class)
+    UNIT_TEST(rs_options_bounded_option)
+
     // unit-test.cpp
 
     return RS::UnitTest::end_tests();
@@ -0,0 +1,1034 @@
+// Generates a header containing a struct of typed option fields and a
+// specialised parser, from a declarative option spec file. See the
+// documentation for the spec file format.
+//
+// Usage: rs-options-gen <spec-file> <output-header>
+//
+// The spec is first loaded into a runtime Options object, which checks it
+// with the same rules as Options::add(), renders the help text, and supplies
+// a saved spec. The generated parser handles well formed command lines on
+// its own; anything else (errors, shell completion, and the rarer forms of
+// argument) is passed to the runtime parser, loaded from the saved spec, so
+// the two always agree.
+
+#include "rs-options/options.hpp"
+#include <algorithm>
+#include <any>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+using namespace RS::Option;
+
+namespace {
+
+    class spec_error:
+    public std::runtime_error {
+    public:
+        explicit spec_error(const std::string& message): std::runtime_error(message) {}
+    };
+
+    struct option_spec {
+        std::string type;
+        std::string name;
+        std::string field;
+        std::string description;
+        std::string default_text;
+        std::string group;
+        std::string pattern;
+        char abbrev = '\0';
+        int flags = 0;
+        bool has_default = false;
+        size_t line = 0;
+    };
+
+    struct file_spec {
+        std::string struct_name = "CommandLine";
+        std::string name_space;
+        std::string app;
+        std::string version;
+        std::string description;
+        std::string extra;
+        bool auto_help = false;
+        std::vector<option_spec> options;
+    };
+
+    // Element types, with the C++ type and the kind of conversion
+
+    enum class convert_kind { boolean, integer, floating, string };
+
+    struct element_type {
+        const char* name;
+        const char* cpp;
+        convert_kind kind;
+    };
+
+    constexpr element_type element_types[] = {
+        { "bool",    "bool",           convert_kind::boolean },
+        { "int",     "int",            convert_kind::integer },
+        { "int64",   "std::int64_t",   convert_kind::integer },
+        { "uint",    "unsigned",       convert_kind::integer },
+        { "uint64",  "std::uint64_t",  convert_kind::integer },
+        { "double",  "double",         convert_kind::floating },
+        { "string",  "std::string",    convert_kind::string },
+    };
+
+    struct type_info {
+        const element_type* element = nullptr;
+        bool multiple = false;
+        std::string cpp() const {
+            return multiple ? "std::vector<" + std::string(element->cpp) + ">" : element->cpp;
+        }
+    };
+
+    type_info find_type(const std::string& type) {
+        std::string name = type;
+        type_info info;
+        if (name.size() > 8 && name.compare(0, 7, "vector<") == 0 && name.back() == '>') {
+            name = name.substr(7, name.size() - 8);
+            info.multiple = true;
+        }
+        for (auto& element: element_types)
+            if (name == element.name)
+                info.element = &element;
+        if (info.element == nullptr || (info.multiple && info.element->kind == convert_kind::boolean))
+            throw spec_error("Unknown option type: " + type);
+        return info;
+    }
+
+    std::string trim_spaces(std::string_view str) {
+        auto i = str.find_first_not_of(" \t\r");
+        if (i == std::string_view::npos)
+            return {};
+        auto j = str.find_last_not_of(" \t\r");
+        return std::string(str.substr(i, j - i + 1));
+    }
+
+    std::vector<std::string> split_words(const std::string& str) {
+        std::istringstream in(str);
+        std::vector<std::string> words;
+        std::string word;
+        while (in >> word)
+            words.push_back(word);
+        return words;
+    }
+
+    bool is_identifier(const std::string& str) {
+        return ! str.empty() && ! (str[0] >= '0' && str[0] <= '9')
+            && std::all_of(str.begin(), str.end(), [] (char c) {
+                return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+            });
+    }
+
+    // Spec file syntax: one setting per line, keyword first; lines after an
+    // "option" line describe that option
+
+    file_spec read_spec(std::istream& in) {
+
+        file_spec spec;
+        option_spec* current = nullptr;
+        std::string line;
+        size_t line_number = 0;
+
+        while (std::getline(in, line)) {
+
+            ++line_number;
+            line = trim_spaces(line);
+
+            if (line.empty() || line[0] == '#')
+                continue;
+
+            auto space = line.find_first_of(" \t");
+            auto key = line.substr(0, space);
+            auto value = space == std::string::npos ? std::string() : trim_spaces(std::string_view(line).substr(space));
+            auto where = " (line " + std::to_string(line_number) + ")";
+
+            if (key == "option") {
+                auto words = split_words(value);
+                if (words.size() != 2)
+                    throw spec_error("Expected option <type> <name>" + where);
+                find_type(words[0]);
+                spec.options.emplace_back();
+                current = &spec.options.back();
+                current->type = words[0];
+                current->name = words[1];
+                current->field = words[1];
+                std::replace(current->field.begin(), current->field.end(), '-', '_');
+                current->line = line_number;
+                if (! is_identifier(current->field) || current->field.back() == '_'
+                        || current->field == "parse" || current->field == "found"
+                        || current->field == "help_text" || current->field == "version_text")
+                    throw spec_error("Option name can't be used as a field name: " + words[1] + where);
+            } else if (current != nullptr) {
+                if (key == "abbrev") {
+                    if (value.size() != 1)
+                        throw spec_error("Expected a single character" + where);
+                    current->abbrev = value[0];
+                } else if (key == "description") {
+                    current->description = value;
+                } else if (key == "default") {
+                    current->default_text = value;
+                    current->has_default = true;
+                } else if (key == "flags") {
+                    for (auto& flag: split_words(value)) {
+                        if (flag == "anon")
+                            current->flags |= Options::anon;
+                        else if (flag == "no_default")
+                            current->flags |= Options::no_default;
+                        else if (flag == "required")
+                            current->flags |= Options::required;
+                        else
+                            throw spec_error("Unsupported flag: " + flag + where);
+                    }
+                } else if (key == "group") {
+                    current->group = value;
+                } else if (key == "pattern") {
+                    current->pattern = value;
+                } else {
+                    throw spec_error("Unknown option setting: " + key + where);
+                }
+            } else if (key == "struct") {
+                if (! is_identifier(value))
+                    throw spec_error("Invalid struct name: " + value + where);
+                spec.struct_name = value;
+            } else if (key == "namespace") {
+                spec.name_space = value;
+            } else if (key == "app") {
+                spec.app = value;
+            } else if (key == "version") {
+                spec.version = value;
+            } else if (key == "description") {
+                spec.description = value;
+            } else if (key == "extra") {
+                spec.extra = value;
+            } else if (key == "auto_help") {
+                spec.auto_help = true;
+            } else {
+                throw spec_error("Unknown setting: " + key + where);
+            }
+
+        }
+
+        return spec;
+
+    }
+
+    template <typename T>
+    T parse_default(const option_spec& opt) {
+        T t{};
+        if (! opt.has_default)
+            return t;
+        auto& text = opt.default_text;
+        auto fail = [&opt] { return spec_error("Invalid default value for --" + opt.name + ": " + opt.default_text); };
+        if constexpr (std::is_same_v<T, bool>) {
+            if (text == "true")
+                t = true;
+            else if (text != "false")
+                throw fail();
+        } else if constexpr (std::is_arithmetic_v<T>) {
+            auto begin = text.data() + (! text.empty() && text[0] == '+');
+            auto end = text.data() + text.size();
+            auto rc = std::from_chars(begin, end, t);
+            if (rc.ec != std::errc() || rc.ptr != end)
+                throw fail();
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            t = text;
+        } else {
+            throw spec_error("Multi-valued options may not have default values: --" + opt.name);
+        }
+        return t;
+    }
+
+    // Runs the callback with a default constructed value of the option's type
+
+    template <typename F>
+    void visit_type(const std::string& type, F f) {
+        auto info = find_type(type);
+        std::string name = info.element->name;
+        if (! info.multiple) {
+            if (name == "bool")           f(bool());
+            else if (name == "int")       f(int());
+            else if (name == "int64")     f(std::int64_t());
+            else if (name == "uint")      f(unsigned());
+            else if (name == "uint64")    f(std::uint64_t());
+            else if (name == "double")    f(double());
+            else                          f(std::string());
+        } else {
+            if (name == "int")            f(std::vector<int>());
+            else if (name == "int64")     f(std::vector<std::int64_t>());
+            else if (name == "uint")      f(std::vector<unsigned>());
+            else if (name == "uint64")    f(std::vector<std::uint64_t>());
+            else if (name == "double")    f(std::vector<double>());
+            else                          f(std::vector<std::string>());
+        }
+    }
+
+    // Octal escapes are always three digits, so they can't run into a
+    // following digit
+
+    std::string cpp_quote(std::string_view str) {
+        std::string result = "\"";
+        for (char c: str) {
+            auto u = uint8_t(c);
+            if (c == '"' || c == '\\') {
+                result += '\\';
+                result += c;
+            } else if (c == '\n') {
+                result += "\\n";
+            } else if (u < 32 || u >= 127) {
+                result += '\\';
+                result += char('0' + (u >> 6));
+                result += char('0' + ((u >> 3) & 7));
+                result += char('0' + (u & 7));
+            } else {
+                result += c;
+            }
+        }
+        result += '"';
+        return result;
+    }
+
+    // Abbreviations are printable, so only the quote and backslash need escaping
+
+    std::string cpp_char(char c) {
+        std::string result = "'";
+        if (c == '\'' || c == '\\')
+            result += '\\';
+        result += c;
+        result += '\'';
+        return result;
+    }
+
+    // Infinities and NaNs have no literal form
+
+    std::string cpp_floating(const std::string& text, const std::string& type) {
+        double x = 0;
+        auto begin = text.data() + (! text.empty() && text[0] == '+');
+        std::from_chars(begin, text.data() + text.size(), x);
+        if (std::isnan(x))
+            return "std::numeric_limits<" + type + ">::quiet_NaN()";
+        else if (std::isinf(x))
+            return (x < 0 ? "-" : "") + ("std::numeric_limits<" + type + ">::infinity()");
+        else if (text.find_first_of(".eE") == std::string::npos)
+            return text + ".0";
+        else
+            return text;
+    }
+
+    // Integers are written from the parsed value, so that the spec's text
+    // can't be read differently by the compiler (e.g. a leading zero as octal)
+
+    template <typename T>
+    std::string cpp_integer(const option_spec& opt, const char* suffix) {
+        auto value = parse_default<T>(opt);
+        if (std::is_signed_v<T> && value == std::numeric_limits<T>::min())
+            return "(" + std::to_string(value + 1) + suffix + " - 1)";
+        return std::to_string(value) + suffix;
+    }
+
+    std::string cpp_integer(const option_spec& opt, const element_type& element) {
+        std::string name = element.name;
+        if (name == "int")         return cpp_integer<int>(opt, "");
+        else if (name == "int64")  return cpp_integer<std::int64_t>(opt, "ll");
+        else if (name == "uint")   return cpp_integer<unsigned>(opt, "u");
+        else                       return cpp_integer<std::uint64_t>(opt, "ull");
+    }
+
+    std::string cpp_view(std::string_view str) {
+        return "std::string_view(" + cpp_quote(str) + ", " + std::to_string(str.size()) + ")";
+    }
+
+    // The perfect hash is FNV-1a with a search for a starting value that
+    // gives each name its own slot
+
+    uint32_t seeded_hash(std::string_view str, uint32_t seed) noexcept {
+        uint32_t h = seed;
+        for (char c: str) {
+            h ^= uint8_t(c);
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    struct hash_entry {
+        std::string key;
+        size_t option;
+        bool invert;
+    };
+
+    struct perfect_hash {
+        uint32_t seed = 0;
+        uint32_t mask = 0;
+        std::vector<hash_entry> entries;
+    };
+
+    perfect_hash make_hash(std::vector<hash_entry> entries) {
+        perfect_hash ph;
+        size_t slots = 4;
+        while (slots < 2 * entries.size())
+            slots *= 2;
+        for (;; slots *= 2) {
+            ph.mask = uint32_t(slots - 1);
+            for (uint32_t attempt = 0; attempt < 10000; ++attempt) {
+                ph.seed = 2166136261u + attempt;
+                std::vector<bool> used(slots, false);
+                bool ok = true;
+                for (auto& entry: entries) {
+                    auto slot = seeded_hash(entry.key, ph.seed) & ph.mask;
+                    if (used[slot]) {
+                        ok = false;
+                        break;
+                    }
+                    used[slot] = true;
+                }
+                if (ok) {
+                    ph.entries = std::move(entries);
+                    return ph;
+                }
+            }
+        }
+    }
+
+    class generator {
+    public:
+        generator(const file_spec& spec, const std::string& source): spec_(spec), source_(source) {}
+        std::string run();
+    private:
+        const file_spec& spec_;
+        std::string source_;
+        Options runtime_;
+        std::deque<std::any> variables_;
+        std::vector<type_info> types_;
+        std::vector<uint16_t> groups_;  // Group index plus one, zero if none
+        std::ostringstream out_;
+        void build_runtime();
+        void write_header();
+        void write_struct();
+        void write_lookup();
+        void write_set_value();
+        void write_fast_parse();
+        void write_fallback();
+        size_t help_index() const noexcept { return spec_.options.size(); }
+        size_t version_index() const noexcept { return spec_.options.size() + 1; }
+        char standard_abbrev(char c) const;
+        std::string indent(int n) const { return std::string(4 * n, ' '); }
+    };
+
+    std::string generator::run() {
+        build_runtime();
+        write_header();
+        return out_.str();
+    }
+
+    void generator::build_runtime() {
+
+        runtime_ = Options(spec_.app, spec_.version, spec_.description, spec_.extra);
+        runtime_.set_colour(false);
+
+        if (spec_.auto_help)
+            runtime_.auto_help();
+
+        std::vector<std::string> group_names;
+
+        for (auto& opt: spec_.options) {
+            visit_type(opt.type, [&] (auto t) {
+                using T = decltype(t);
+                auto& var = std::any_cast<T&>(variables_.emplace_back(parse_default<T>(opt)));
+                runtime_.add(var, opt.name, opt.abbrev, opt.description, opt.flags, opt.group, opt.pattern);
+            });
+            types_.push_back(find_type(opt.type));
+            uint16_t group = 0;
+            if (! opt.group.empty()) {
+                auto it = std::find(group_names.begin(), group_names.end(), opt.group);
+                group = uint16_t(it - group_names.begin() + 1);
+                if (it == group_names.end())
+                    group_names.push_back(opt.group);
+            }
+            groups_.push_back(group);
+        }
+
+    }
+
+    char generator::standard_abbrev(char c) const {
+        for (auto& opt: spec_.options)
+            if (opt.abbrev == c)
+                return '\0';
+        return c;
+    }
+
+    void generator::write_header() {
+
+        // The help and version text come from the runtime parser itself
+
+        std::ostringstream help;
+        std::ostringstream version;
+        auto help_options = runtime_;
+        auto version_options = runtime_;
+        help_options.parse({"--help"}, help);
+        version_options.parse({"--version"}, version);
+        auto spec_data = runtime_.save_spec();
+
+        out_ << "// Generated by rs-options-gen from " << source_ << "; do not edit\n"
+            << "\n"
+            << "#pragma once\n"
+            << "\n"
+            << "#include \"rs-options/options.hpp\"\n"
+            << "#include <array>\n"
+            << "#include <charconv>\n"
+            << "#include <cstddef>\n"
+            << "#include <cstdint>\n"
+            << "#include <iostream>\n"
+            << "#include <limits>\n"
+            << "#include <ostream>\n"
+            << "#include <string>\n"
+            << "#include <string_view>\n"
+            << "#include <system_error>\n"
+            << "#include <type_traits>\n"
+            << "#include <vector>\n"
+            << "\n";
+
+        if (! spec_.name_space.empty())
+            out_ << "namespace " << spec_.name_space << " {\n\n";
+
+        write_struct();
+        out_ << "\n";
+        out_ << indent(1) << "inline constexpr std::string_view " << spec_.struct_name << "::help_text;\n";
+        out_ << indent(1) << "inline constexpr std::string_view " << spec_.struct_name << "::version_text;\n";
+        out_ << indent(1) << "inline constexpr std::string_view " << spec_.struct_name << "::spec_data;\n";
+        out_ << "\n";
+        write_lookup();
+        write_set_value();
+        write_fast_parse();
+        write_fallback();
+
+        if (! spec_.name_space.empty())
+            out_ << "}\n";
+
+        // Text members are filled in last, once they are known
+
+        auto text = out_.str();
+        auto fill = [&text] (const std::string& marker, const std::string& value) {
+            auto pos = text.find(marker);
+            text.replace(pos, marker.size(), value);
+        };
+        fill("@HELP@", cpp_view(help.str()));
+        fill("@VERSION@", cpp_view(version.str()));
+        fill("@SPEC@", cpp_view(spec_data));
+        out_.str(text);
+        out_.seekp(0, std::ios::end);
+
+    }
+
+    void generator::write_struct() {
+
+        auto& name = spec_.struct_name;
+        size_t n = spec_.options.size() + 2;
+
+        out_ << indent(1) << "struct " << name << " {\n\n";
+
+        for (size_t i = 0; i < spec_.options.size(); ++i) {
+            auto& opt = spec_.options[i];
+            auto& info = types_[i];
+            out_ << indent(2) << info.cpp() << " " << opt.field;
+            if (opt.has_default) {
+                if (info.element->kind == convert_kind::string)
+                    out_ << " = " << cpp_quote(opt.default_text);
+                else if (info.element->kind == convert_kind::floating)
+                    out_ << " = " << cpp_floating(opt.default_text, info.element->cpp);
+                else if (info.element->kind == convert_kind::integer)
+                    out_ << " = " << cpp_integer(opt, *info.element);
+                else
+                    out_ << " = " << opt.default_text;
+            } else if (! info.multiple && info.element->kind != convert_kind::string) {
+                out_ << " = {}";
+            }
+            out_ << ";\n";
+        }
+
+        out_ << "\n"
+            << indent(2) << "static constexpr std::string_view help_text = @HELP@;\n"
+            << indent(2) << "static constexpr std::string_view version_text = @VERSION@;\n"
+            << "\n"
+            << indent(2) << "bool parse(int argc, char** argv, std::ostream& out = std::cout);\n"
+            << indent(2) << "bool parse(const std::vector<std::string>& args, std::ostream& out = std::cout);\n"
+            << indent(2) << "bool found(std::string_view name) const noexcept;\n"
+            << "\n"
+            << indent(1) << "private:\n"
+            << "\n"
+            << indent(2) << "// Saved runtime spec, used for anything the generated parser doesn't handle\n"
+            << indent(2) << "static constexpr std::string_view spec_data = @SPEC@;\n"
+            << indent(2) << "static constexpr std::size_t option_count = " << n << ";\n"
+            << indent(2) << "enum class step { done, exit, fallback };\n"
+            << "\n"
+            << indent(2) << "std::array<bool, option_count> found_ = {};\n"
+            << "\n"
+            << indent(2) << "static int lookup(std::string_view key) noexcept;\n"
+            << indent(2) << "static int lookup(char abbrev) noexcept;\n"
+            << indent(2) << "template <typename T> static bool to_integer(std::string_view str, T& t) noexcept;\n"
+            << indent(2) << "static bool to_floating(std::string_view str, double& t) noexcept;\n"
+            << indent(2) << "bool set_value(int option, std::string_view str);\n"
+            << indent(2) << "step fast_parse(const std::vector<std::string_view>& args, std::ostream& out);\n"
+            << indent(2) << "bool runtime_parse(const std::vector<std::string>& args, std::ostream& out);\n"
+            << "\n"
+            << indent(1) << "};\n";
+
+    }
+
+    void generator::write_lookup() {
+
+        auto& name = spec_.struct_name;
+
+        // Same entries as the runtime name index: every name, plus the
+        // inverted forms of boolean options, which win any clash
+
+        std::vector<hash_entry> entries;
+
+        for (size_t i = 0; i < spec_.options.size(); ++i) {
+            entries.push_back({spec_.options[i].name, i, false});
+            if (types_[i].element->kind == convert_kind::boolean)
+                entries.push_back({"no-" + spec_.options[i].name, i, true});
+        }
+
+        entries.push_back({"help", help_index(), false});
+        entries.push_back({"no-help", help_index(), true});
+        entries.push_back({"version", version_index(), false});
+        entries.push_back({"no-version", version_index(), true});
+
+        std::sort(entries.begin(), entries.end(), [] (auto& a, auto& b) {
+            return a.key == b.key ? a.invert && ! b.invert : a.key < b.key;
+        });
+        entries.erase(std::unique(entries.begin(), entries.end(),
+            [] (auto& a, auto& b) { return a.key == b.key; }), entries.end());
+
+        auto ph = make_hash(std::move(entries));
+        std::map<uint32_t, const hash_entry*> slots;
+
+        for (auto& entry: ph.entries)
+            slots[seeded_hash(entry.key, ph.seed) & ph.mask] = &entry;
+
+        // Returns the option index times two, plus one for an inverted
+        // boolean, or -1 if not found
+
+        out_ << indent(1) << "inline int " << name << "::lookup(std::string_view key) noexcept {\n"
+            << indent(2) << "std::uint32_t hash = " << ph.seed << "u;\n"
+            << indent(2) << "for (char c: key) {\n"
+            << indent(3) << "hash ^= std::uint8_t(c);\n"
+            << indent(3) << "hash *= 16777619u;\n"
+            << indent(2) << "}\n"
+            << indent(2) << "switch (hash & " << ph.mask << "u) {\n";
+
+        for (auto& [slot, entry]: slots)
+            out_ << indent(3) << "case " << slot << ": return key == " << cpp_quote(entry->key)
+                << " ? " << (2 * entry->option + entry->invert) << " : -1;\n";
+
+        out_ << indent(3) << "default: return -1;\n"
+            << indent(2) << "}\n"
+            << indent(1) << "}\n\n";
+
+        out_ << indent(1) << "inline int " << name << "::lookup(char abbrev) noexcept {\n"
+            << indent(2) << "switch (abbrev) {\n";
+
+        for (size_t i = 0; i < spec_.options.size(); ++i)
+            if (spec_.options[i].abbrev != '\0')
+                out_ << indent(3) << "case " << cpp_char(spec_.options[i].abbrev) << ": return " << i << ";\n";
+
+        if (char h = standard_abbrev('h'))
+            out_ << indent(3) << "case " << cpp_char(h) << ": return " << help_index() << ";\n";
+        if (char v = standard_abbrev('v'))
+            out_ << indent(3) << "case " << cpp_char(v) << ": return " << version_index() << ";\n";
+
+        out_ << indent(3) << "default: return -1;\n"
+            << indent(2) << "}\n"
+            << indent(1) << "}\n\n";
+
+        out_ << indent(1) << "inline bool " << name << "::found(std::string_view name) const noexcept {\n"
+            << indent(2) << "while (! name.empty() && name[0] == '-')\n"
+            << indent(3) << "name.remove_prefix(1);\n"
+            << indent(2) << "int code = lookup(name);\n"
+            << indent(2) << "return code >= 0 && code % 2 == 0 && found_[code / 2];\n"
+            << indent(1) << "}\n\n";
+
+        // Conversions follow the runtime's validators: an optional sign,
+        // then digits, or the usual decimal floating point form
+
+        out_ << indent(1) << "template <typename T>\n"
+            << indent(1) << "bool " << name << "::to_integer(std::string_view str, T& t) noexcept {\n"
+            << indent(2) << "std::size_t i = 0;\n"
+            << indent(2) << "if (i < str.size() && (str[i] == '+' || (std::is_signed_v<T> && str[i] == '-')))\n"
+            << indent(3) << "++i;\n"
+            << indent(2) << "if (i == str.size())\n"
+            << indent(3) << "return false;\n"
+            << indent(2) << "for (std::size_t j = i; j < str.size(); ++j)\n"
+            << indent(3) << "if (str[j] < '0' || str[j] > '9')\n"
+            << indent(4) << "return false;\n"
+            << indent(2) << "auto begin = str.data() + (str[0] == '+');\n"
+            << indent(2) << "auto end = str.data() + str.size();\n"
+            << indent(2) << "auto rc = std::from_chars(begin, end, t);\n"
+            << indent(2) << "return rc.ec == std::errc() && rc.ptr == end;\n"
+            << indent(1) << "}\n\n";
+
+        out_ << indent(1) << "inline bool " << name << "::to_floating(std::string_view str, double& t) noexcept {\n"
+            << indent(2) << "auto digits = [&str] (std::size_t& i) {\n"
+            << indent(3) << "auto start = i;\n"
+            << indent(3) << "while (i < str.size() && str[i] >= '0' && str[i] <= '9')\n"
+            << indent(4) << "++i;\n"
+            << indent(3) << "return i > start;\n"
+            << indent(2) << "};\n"
+            << indent(2) << "std::size_t i = 0;\n"
+            << indent(2) << "if (i < str.size() && (str[i] == '+' || str[i] == '-'))\n"
+            << indent(3) << "++i;\n"
+            << indent(2) << "bool whole = digits(i);\n"
+            << indent(2) << "bool fraction = false;\n"
+            << indent(2) << "if (i < str.size() && str[i] == '.') {\n"
+            << indent(3) << "++i;\n"
+            << indent(3) << "fraction = digits(i);\n"
+            << indent(2) << "}\n"
+            << indent(2) << "if (! whole && ! fraction)\n"
+            << indent(3) << "return false;\n"
+            << indent(2) << "if (i < str.size() && (str[i] == 'E' || str[i] == 'e')) {\n"
+            << indent(3) << "++i;\n"
+            << indent(3) << "if (i < str.size() && (str[i] == '+' || str[i] == '-'))\n"
+            << indent(4) << "++i;\n"
+            << indent(3) << "if (! digits(i))\n"
+            << indent(4) << "return false;\n"
+            << indent(2) << "}\n"
+            << indent(2) << "if (i != str.size())\n"
+            << indent(3) << "return false;\n"
+            << indent(2) << "auto begin = str.data() + (str[0] == '+');\n"
+            << indent(2) << "auto end = str.data() + str.size();\n"
+            << indent(2) << "auto rc = std::from_chars(begin, end, t);\n"
+            << indent(2) << "return rc.ec == std::errc() && rc.ptr == end;\n"
+            << indent(1) << "}\n\n";
+
+    }
+
+    void generator::write_set_value() {
+
+        out_ << indent(1) << "inline bool " << spec_.struct_name << "::set_value(int option, std::string_view str) {\n"
+            << indent(2) << "switch (option) {\n";
+
+        for (size_t i = 0; i < spec_.options.size(); ++i) {
+
+            auto& opt = spec_.options[i];
+            auto& info = types_[i];
+            auto kind = info.element->kind;
+
+            if (kind == convert_kind::boolean)
+                continue;
+
+            out_ << indent(3) << "case " << i << ": {\n";
+
+            if (kind == convert_kind::string && ! opt.pattern.empty())
+                out_ << indent(4) << "static const RS::RE::Regex pattern(" << cpp_quote(opt.pattern)
+                        << ", RS::RE::Regex::full | RS::RE::Regex::no_capture);\n"
+                    << indent(4) << "if (! pattern(std::string(str)).matched())\n"
+                    << indent(5) << "return false;\n";
+
+            std::string target = info.multiple ? "value" : opt.field;
+
+            if (info.multiple && kind != convert_kind::string)
+                out_ << indent(4) << info.element->cpp << " value = {};\n";
+
+            if (kind == convert_kind::integer)
+                out_ << indent(4) << "if (! to_integer(str, " << target << "))\n"
+                    << indent(5) << "return false;\n";
+            else if (kind == convert_kind::floating)
+                out_ << indent(4) << "if (! to_floating(str, " << target << "))\n"
+                    << indent(5) << "return false;\n";
+            else if (! info.multiple)
+                out_ << indent(4) << opt.field << " = std::string(str);\n";
+
+            if (info.multiple)
+                out_ << indent(4) << opt.field << ".push_back("
+                    << (kind == convert_kind::string ? "std::string(str)" : "value") << ");\n";
+
+            out_ << indent(4) << "return true;\n"
+                << indent(3) << "}\n";
+
+        }
+
+        out_ << indent(3) << "default:\n"
+            << indent(4) << "return false;\n"
+            << indent(2) << "}\n"
+            << indent(1) << "}\n\n";
+
+    }
+
+    void generator::write_fast_parse() {
+
+        auto& name = spec_.struct_name;
+        size_t n = spec_.options.size() + 2;
+        auto table = [n] (auto pred) {
+            std::string list;
+            for (size_t i = 0; i < n; ++i)
+                list += std::string(i == 0 ? "" : ", ") + (pred(i) ? "true" : "false");
+            return list;
+        };
+        auto is_boolean = [this] (size_t i) {
+            return i >= spec_.options.size() || types_[i].element->kind == convert_kind::boolean;
+        };
+        auto is_multiple = [this] (size_t i) { return i < spec_.options.size() && types_[i].multiple; };
+        auto is_required = [this] (size_t i) {
+            return i < spec_.options.size() && (spec_.options[i].flags & Options::required) != 0;
+        };
+
+        std::string groups;
+        std::string anons;
+
+        for (size_t i = 0; i < n; ++i) {
+            groups += std::string(i == 0 ? "" : ", ") + std::to_string(i < groups_.size() ? groups_[i] : 0);
+            if (i < spec_.options.size() && (spec_.options[i].flags & Options::anon) != 0)
+                anons += std::string(anons.empty() ? "" : ", ") + std::to_string(i);
+        }
+
+        // The token rules are those of the runtime parser. Errors, and any
+        // case where the two might not agree, return step::fallback, and
+        // the whole command line is given to the runtime parser instead.
+
+        out_ << indent(1) << "inline " << name << "::step " << name
+                << "::fast_parse(const std::vector<std::string_view>& args, std::ostream& out) {\n"
+            << "\n"
+            << indent(2) << "static constexpr bool is_boolean[] = {" << table(is_boolean) << "};\n"
+            << indent(2) << "static constexpr bool is_multiple[] = {" << table(is_multiple) << "};\n"
+            << indent(2) << "static constexpr bool is_required[] = {" << table(is_required) << "};\n"
+            << indent(2) << "static constexpr int group[] = {" << groups << "};\n";
+
+        if (! anons.empty())
+            out_ << indent(2) << "static constexpr int anon[] = {" << anons << "};\n";
+
+        out_ << "\n"
+            << indent(2) << "if (! args.empty() && args[0] == RS::Option::Options::complete_option)\n"
+            << indent(3) << "return step::fallback;\n"
+            << "\n";
+
+        if (spec_.auto_help)
+            out_ << indent(2) << "if (args.empty()) {\n"
+                << indent(3) << "out << help_text;\n"
+                << indent(3) << "return step::exit;\n"
+                << indent(2) << "}\n"
+                << "\n";
+
+        size_t group_count = groups_.empty() ? 0 : *std::max_element(groups_.begin(), groups_.end());
+
+        out_ << indent(2) << "std::array<bool, " << (group_count + 1) << "> group_found = {};\n"
+            << indent(2) << "int current = -1;\n"
+            << indent(2) << "bool waiting = false;  // Current option has no argument yet\n"
+            << indent(2) << "bool escaped = false;\n"
+            << "\n"
+            << indent(2) << "auto match = [&] (int option) {\n"
+            << indent(3) << "if (found_[option] && ! is_multiple[option])\n"
+            << indent(4) << "return false;\n"
+            << indent(3) << "if (group[option] != 0 && ! found_[option]) {\n"
+            << indent(4) << "if (group_found[group[option]])\n"
+            << indent(5) << "return false;\n"
+            << indent(4) << "group_found[group[option]] = true;\n"
+            << indent(3) << "}\n"
+            << indent(3) << "found_[option] = true;\n"
+            << indent(3) << "return true;\n"
+            << indent(2) << "};\n"
+            << "\n"
+            << indent(2) << "auto set_flag = [&] (int option, [[maybe_unused]] bool value) {\n"
+            << indent(3) << "switch (option) {\n";
+
+        for (size_t i = 0; i < spec_.options.size(); ++i)
+            if (types_[i].element->kind == convert_kind::boolean)
+                out_ << indent(4) << "case " << i << ": " << spec_.options[i].field << " = value; break;\n";
+
+        out_ << indent(4) << "default: break;\n"
+            << indent(3) << "}\n"
+            << indent(2) << "};\n"
+            << "\n"
+            << indent(2) << "for (auto arg: args) {\n"
+            << "\n"
+            << indent(3) << "if (escaped || arg.empty() || arg[0] != '-') {\n"
+            << indent(4) << "if (current < 0) {\n";
+
+        if (anons.empty()) {
+            out_ << indent(5) << "return step::fallback;\n";
+        } else {
+            out_ << indent(5) << "for (int option: anon) {\n"
+                << indent(6) << "if (is_multiple[option] || ! found_[option]) {\n"
+                << indent(7) << "current = option;\n"
+                << indent(7) << "break;\n"
+                << indent(6) << "}\n"
+                << indent(5) << "}\n"
+                << indent(5) << "if (current < 0 || ! match(current))\n"
+                << indent(6) << "return step::fallback;\n";
+        }
+
+        out_ << indent(4) << "}\n"
+            << indent(4) << "if (! set_value(current, arg))\n"
+            << indent(5) << "return step::fallback;\n"
+            << indent(4) << "waiting = false;\n"
+            << indent(4) << "if (! is_multiple[current])\n"
+            << indent(5) << "current = -1;\n"
+            << indent(4) << "continue;\n"
+            << indent(3) << "}\n"
+            << "\n"
+            << indent(3) << "if (arg == \"--\") {\n"
+            << indent(4) << "escaped = true;\n"
+            << indent(4) << "continue;\n"
+            << indent(3) << "}\n"
+            << "\n"
+            << indent(3) << "if (waiting || arg.size() < 2)\n"
+            << indent(4) << "return step::fallback;\n"
+            << "\n"
+            << indent(3) << "current = -1;\n"
+            << "\n"
+            << indent(3) << "if (arg[1] == '-') {\n"
+            << indent(4) << "auto eq_pos = arg.find('=');\n"
+            << indent(4) << "int code = lookup(arg.substr(2, eq_pos == std::string_view::npos ? eq_pos : eq_pos - 2));\n"
+            << indent(4) << "if (code < 0 || ! match(code / 2))\n"
+            << indent(5) << "return step::fallback;\n"
+            << indent(4) << "int option = code / 2;\n"
+            << indent(4) << "if (is_boolean[option]) {\n"
+            << indent(5) << "if (eq_pos != std::string_view::npos)\n"
+            << indent(6) << "return step::fallback;\n"
+            << indent(5) << "set_flag(option, code % 2 == 0);\n"
+            << indent(4) << "} else if (eq_pos == std::string_view::npos) {\n"
+            << indent(5) << "current = option;\n"
+            << indent(5) << "waiting = true;\n"
+            << indent(4) << "} else if (eq_pos < 4 || ! set_value(option, arg.substr(eq_pos + 1))) {\n"
+            << indent(5) << "return step::fallback;\n"
+            << indent(4) << "} else if (is_multiple[option]) {\n"
+            << indent(5) << "current = option;\n"
+            << indent(4) << "}\n"
+            << indent(4) << "continue;\n"
+            << indent(3) << "}\n"
+            << "\n"
+            << indent(3) << "for (char c: arg.substr(1)) {\n"
+            << indent(4) << "int option = lookup(c);\n"
+            << indent(4) << "if (option < 0 || waiting || ! match(option))\n"
+            << indent(5) << "return step::fallback;\n"
+            << indent(4) << "if (is_boolean[option]) {\n"
+            << indent(5) << "set_flag(option, true);\n"
+            << indent(4) << "} else {\n"
+            << indent(5) << "current = option;\n"
+            << indent(5) << "waiting = true;\n"
+            << indent(4) << "}\n"
+            << indent(3) << "}\n"
+            << "\n"
+            << indent(2) << "}\n"
+            << "\n"
+            << indent(2) << "if (waiting)\n"
+            << indent(3) << "return step::fallback;\n"
+            << "\n"
+            << indent(2) << "if (found_[" << help_index() << "]) {\n"
+            << indent(3) << "out << help_text;\n"
+            << indent(3) << "return step::exit;\n"
+            << indent(2) << "}\n"
+            << "\n"
+            << indent(2) << "if (found_[" << version_index() << "]) {\n"
+            << indent(3) << "out << version_text;\n"
+            << indent(3) << "return step::exit;\n"
+            << indent(2) << "}\n"
+            << "\n"
+            << indent(2) << "for (std::size_t i = 0; i < option_count; ++i)\n"
+            << indent(3) << "if (is_required[i] && ! found_[i])\n"
+            << indent(4) << "return step::fallback;\n"
+            << "\n"
+            << indent(2) << "return step::done;\n"
+            << "\n"
+            << indent(1) << "}\n\n";
+
+    }
+
+    void generator::write_fallback() {
+
+        auto& name = spec_.struct_name;
+
+        out_ << indent(1) << "inline bool " << name << "::runtime_parse(const std::vector<std::string>& args, std::ostream& out) {\n"
+            << indent(2) << "auto opt = RS::Option::Options::load_spec(spec_data);\n"
+            << indent(2) << name << " result;\n";
+
+        for (auto& opt: spec_.options)
+            out_ << indent(2) << "opt.bind(result." << opt.field << ", " << cpp_quote(opt.name) << ");\n";
+
+        out_ << indent(2) << "bool proceed = opt.parse(args, out);\n";
+
+        for (size_t i = 0; i < spec_.options.size(); ++i)
+            out_ << indent(2) << "result.found_[" << i << "] = opt.found(" << cpp_quote(spec_.options[i].name) << ");\n";
+
+        out_ << indent(2) << "result.found_[" << help_index() << "] = opt.found(\"help\");\n"
+            << indent(2) << "result.found_[" << version_index() << "] = opt.found(\"version\");\n"
+            << indent(2) << "if (proceed)\n"
+            << indent(3) << "*this = std::move(result);\n"
+            << indent(2) << "return proceed;\n"
+            << indent(1) << "}\n\n";
+
+        out_ << indent(1) << "inline bool " << name << "::parse(const std::vector<std::string>& args, std::ostream& out) {\n"
+            << indent(2) << "std::vector<std::string_view> views(args.begin(), args.end());\n"
+            << indent(2) << name << " result;\n"
+            << indent(2) << "switch (result.fast_parse(views, out)) {\n"
+            << indent(3) << "case step::done:      *this = std::move(result); return true;\n"
+            << indent(3) << "case step::exit:      return false;\n"
+            << indent(3) << "default:              return runtime_parse(args, out);\n"
+            << indent(2) << "}\n"
+            << indent(1) << "}\n\n";
+
+        out_ << indent(1) << "inline bool " << name << "::parse(int argc, char** argv, std::ostream& out) {\n"
+            << indent(2) << "std::vector<std::string_view> views(argv + 1, argv + argc);\n"
+            << indent(2) << name << " result;\n"
+            << indent(2) << "switch (result.fast_parse(views, out)) {\n"
+            << indent(3) << "case step::done:      *this = std::move(result); return true;\n"
+            << indent(3) << "case step::exit:      return false;\n"
+            << indent(3) << "default:              return runtime_parse({argv + 1, argv + argc}, out);\n"
+            << indent(2) << "}\n"
+            << indent(1) << "}\n\n";
+
+    }
+
+}
+
+int main(int argc, char** argv) {
+
+    if (argc != 3) {
+        std::cerr << "Usage: rs-options-gen <spec-file> <output-header>\n";
+        return 2;
+    }
+
+    try {
+
+        std::ifstream in(argv[1]);
+        if (! in)
+            throw spec_error("Can't read spec file: " + std::string(argv[1]));
+        auto spec = read_spec(in);
+        std::string source = argv[1];
+        auto slash = source.find_last_of("/\\");
+        if (slash != std::string::npos)
+            source.erase(0, slash + 1);
+        auto text = generator(spec, source).run();
+
+        // Unchanged output is not rewritten, so dependents are not rebuilt
+
+        std::ifstream old(argv[2], std::ios::binary);
+        std::string old_text((std::istreambuf_iterator<char>(old)), std::istreambuf_iterator<char>());
+        if (old_text == text)
+            return 0;
+        old.close();
+
+        std::ofstream out(argv[2], std::ios::binary);
+        out << text;
+        if (! out)
+            throw spec_error("Can't write output file: " + std::string(argv[2]));
+
+    }
+    catch (const std::exception& ex) {
+        std::cerr << "rs-options-gen: " << argv[1] << ": " << ex.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+
+}